@@ -1,11 +1,11 @@
 #version 330 core 
 
-in vec2 frag_uv;
+in vec3 frag_uv; // uv and texture array layer
 in float frag_light;
 
 out vec4 frag_color;
 
-uniform sampler2D block_texture;
+uniform sampler2DArray block_texture;
 
 void main() 
 {
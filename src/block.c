@@ -10,6 +10,7 @@ bool block_is_transparent(BlockType type) {
         case BLOCK_LIGHT:
         case BLOCK_GRASS:
         case BLOCK_STONE:
+        case BLOCK_TYPE_COUNT:
             return false;
     }
     return false;
@@ -20,6 +21,10 @@ bool block_is_opaque(BlockType type) {
     return false;
 }
 
+bool block_is_translucent(BlockType type) {
+    return type == BLOCK_GLASS;
+}
+
 bool block_in_chunk(ivec3 pos) { // does not check in world coords
     return (
         pos[0] >= 0 && pos[0] < CHUNK_SIZE &&
@@ -29,6 +34,6 @@ bool block_in_chunk(ivec3 pos) { // does not check in world coords
 }
 
 uint8_t block_get_emission(BlockType type) {
-    if (BLOCK_LIGHT) return 15;
+    if (type == BLOCK_LIGHT) return 15;
     return 0;
 }
@@ -10,7 +10,8 @@ typedef enum BlockType {
 	BLOCK_LIGHT,
     BLOCK_GLASS,
     BLOCK_GRASS,
-	BLOCK_STONE
+	BLOCK_STONE,
+    BLOCK_TYPE_COUNT // not a block, bounds saved types
 } BlockType;
 
 typedef struct Block {
@@ -20,6 +21,7 @@ typedef struct Block {
 
 bool block_is_transparent(BlockType type);
 bool block_is_opaque(BlockType type);
+bool block_is_translucent(BlockType type); // needs blending, drawn in its own pass
 bool block_in_chunk(ivec3 pos);
 uint8_t block_get_emission(BlockType type);
 
@@ -1,30 +1,48 @@
 #include "chunk.h"
 #include "world.h"
+#include "upload_ring.h"
 
 #include <cglm/cglm.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 
-void add_face(Chunk* chunk, vec3 pos, int face, BlockType block_type, uint8_t light_level) {
-    const float tile_size = 1.0f / 16.0f; // 16x16 tiles
-    const float epsilon = 0.001f;
-
-    int tile_x = block_type % 16;
-    int tile_y = block_type / 16;
+// geometry is built here and copied to the gpu, meshes only keep counts and ranges
+typedef struct {
+    Vertex* vertices;
+    unsigned int* indices;
+    size_t vertex_count;
+    size_t index_count;
+    size_t vertex_capacity;
+    size_t index_capacity;
+} MeshStaging;
+
+static MeshStaging staging;
+static UploadRing upload_ring;
+static bool upload_ring_ready = false;
+static bool keep_mesh_data = false; // copy built geometry into the mesh for debug and export tools
+
+void chunk_set_keep_mesh_data(bool keep) {
+    keep_mesh_data = keep;
+}
 
-    tile_y = 15 - tile_y;
+void chunk_free_staging(void) {
+    free(staging.vertices);
+    free(staging.indices);
+    memset(&staging, 0, sizeof(staging));
 
-    vec2 base_uv = {
-        tile_x * tile_size + epsilon,
-        tile_y * tile_size + epsilon
-    };
+    upload_ring_free(&upload_ring);
+    upload_ring_ready = false;
+}
 
+// scale is the edge length of the face in blocks, pos its cube center
+static void add_face(MeshStaging* mesh, vec3 pos, int face, BlockType block_type, uint8_t light_level, float scale) {
+    // the texture array repeats, so a face scale blocks wide shows the tile scale times
     vec2 uv_offsets[4] = {
         {0.0f, 0.0f},
-        {tile_size - 2 * epsilon, 0.0f},
-        {tile_size - 2 * epsilon, tile_size - 2 * epsilon},
-        {0.0f, tile_size - 2 * epsilon}
+        {1.0f, 0.0f},
+        {1.0f, 1.0f},
+        {0.0f, 1.0f}
     };
 
     vec3 face_offsets[6][4] = {
@@ -71,44 +89,300 @@ void add_face(Chunk* chunk, vec3 pos, int face, BlockType block_type, uint8_t li
         }
     };
 
-    // Reallocate vertex buffer
-    Vertex* new_vertices = realloc(chunk->vertices, sizeof(Vertex) * (chunk->vertex_count + 4));    
-
-    if (!new_vertices) {
-        fprintf(stderr, "Failed to realloc vertices\n");
-        return;
+    // grow the staging buffers, kept between builds
+    if (mesh->vertex_count + 4 > mesh->vertex_capacity) {
+        size_t capacity = mesh->vertex_capacity ? mesh->vertex_capacity * 2 : 4096;
+        Vertex* new_vertices = realloc(mesh->vertices, sizeof(Vertex) * capacity);
+        if (!new_vertices) {
+            fprintf(stderr, "Failed to realloc vertices\n");
+            return;
+        }
+        mesh->vertices = new_vertices;
+        mesh->vertex_capacity = capacity;
+    }
+    if (mesh->index_count + 6 > mesh->index_capacity) {
+        size_t capacity = mesh->index_capacity ? mesh->index_capacity * 2 : 6144;
+        unsigned int* new_indices = realloc(mesh->indices, sizeof(unsigned int) * capacity);
+        if (!new_indices) {
+            fprintf(stderr, "Failed to realloc indices\n");
+            return;
+        }
+        mesh->indices = new_indices;
+        mesh->index_capacity = capacity;
     }
-    chunk->vertices = new_vertices;
 
     // Add 4 vertices for the face
     for (int i = 0; i < 4; ++i) {
         Vertex v;
-        glm_vec3_copy(face_offsets[face][i], v.position);
+        glm_vec3_scale(face_offsets[face][i], scale, v.position);
         glm_vec3_add(v.position, pos, v.position);
 
-        glm_vec2_add(base_uv, uv_offsets[i], v.uv);
+        glm_vec2_scale(uv_offsets[i], scale, v.uv);
+        v.layer = (float)block_type; // one layer per atlas tile
 
         v.light = light_level / 15.0f; // normalize to 0.0 - 1.0
 
-        chunk->vertices[chunk->vertex_count++] = v;
+        mesh->vertices[mesh->vertex_count++] = v;
     }
 
-    // Reallocate index buffer
-    unsigned int* new_indices = realloc(chunk->indices, sizeof(unsigned int) * (chunk->index_count + 6));
-    if (!new_indices) {
-        fprintf(stderr, "Failed to realloc indices\n");
-        return;
+    unsigned int base = mesh->vertex_count - 4;
+
+    mesh->indices[mesh->index_count++] = base;
+    mesh->indices[mesh->index_count++] = base + 1;
+    mesh->indices[mesh->index_count++] = base + 2;
+    mesh->indices[mesh->index_count++] = base + 2;
+    mesh->indices[mesh->index_count++] = base + 3;
+    mesh->indices[mesh->index_count++] = base;
+}
+
+static const int face_normals[DIR_COUNT][3] = {
+    { 1,  0,  0}, // +X
+    {-1,  0,  0}, // -X
+    { 0,  1,  0}, // +Y
+    { 0, -1,  0}, // -Y
+    { 0,  0,  1}, // +Z
+    { 0,  0, -1}  // -Z
+};
+
+// cells to mesh plus a one cell border holding the neighbors
+#define GRID_SIZE (CHUNK_SIZE + 2)
+
+typedef struct {
+    BlockType type[GRID_SIZE * GRID_SIZE * GRID_SIZE];
+    uint8_t light[GRID_SIZE * GRID_SIZE * GRID_SIZE];
+} MeshGrid;
+
+static int grid_index(int x, int y, int z) { // -1 to CHUNK_SIZE on every axis
+    return ((x + 1) * GRID_SIZE + (y + 1)) * GRID_SIZE + (z + 1);
+}
+
+// emits the faces of the cells in layers [y_begin, y_end) of a size^3 grid of cells
+// scale blocks wide, grouped by pass and direction so the renderer can skip whole ranges
+// the result stays in the staging buffers until mesh_upload
+static void mesh_build(ChunkMesh* mesh, const MeshGrid* grid, int size, int y_begin, int y_end, int scale) {
+    staging.vertex_count = 0;
+    staging.index_count = 0;
+
+    for (MeshPass pass = 0; pass < MESH_PASS_COUNT; ++pass) {
+        for (Direction d = 0; d < DIR_COUNT; ++d) {
+            mesh->face_offset[pass][d] = staging.index_count;
+
+            for (int x = 0; x < size; ++x) {
+                for (int y = y_begin; y < y_end; ++y) {
+                    for (int z = 0; z < size; ++z) {
+                        BlockType bt = grid->type[grid_index(x, y, z)];
+                        if (bt == BLOCK_AIR) continue;
+                        if (block_is_translucent(bt) != (pass == MESH_PASS_TRANSLUCENT)) continue;
+
+                        int neighbor = grid_index(x + face_normals[d][0], y + face_normals[d][1], z + face_normals[d][2]);
+                        BlockType nb = grid->type[neighbor];
+
+                        if (nb == BLOCK_AIR || nb != bt) {
+                            // cell center in block coordinates
+                            float offset = (scale - 1) * 0.5f;
+                            vec3 posf = { x * scale + offset, y * scale + offset, z * scale + offset };
+                            add_face(&staging, posf, d, bt, grid->light[neighbor], (float)scale);
+                        }
+                    }
+                }
+            }
+
+            mesh->face_count[pass][d] = staging.index_count - mesh->face_offset[pass][d];
+        }
+    }
+
+    mesh->vertex_count = staging.vertex_count;
+    mesh->index_count = staging.index_count;
+}
+
+// gl objects are created by the first upload, so chunks can be set up
+// and edited without a context
+static void mesh_init(ChunkMesh* mesh) {
+    memset(mesh, 0, sizeof(*mesh));
+    mesh->index_type = GL_UNSIGNED_INT;
+}
+
+static void mesh_create_buffers(ChunkMesh* mesh) {
+	glGenVertexArrays(1, &mesh->vao);
+    glGenBuffers(1, &mesh->vbo);
+	glGenBuffers(1, &mesh->ebo);
+
+    // attributes point at the buffer object and survive storage reallocation
+    glBindVertexArray(mesh->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(vec3)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(vec3) + sizeof(vec2)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(vec3) + sizeof(vec2) + sizeof(float)));
+    glEnableVertexAttribArray(3);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+    glBindVertexArray(0);
+}
+
+// reallocates gpu storage only when the mesh outgrows it, with headroom for later edits
+static void mesh_reserve(GLuint buffer, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) return;
+
+    size_t bytes = needed + needed / 2;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, bytes, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    *capacity = bytes;
+}
+
+static void mesh_free(ChunkMesh* mesh) {
+    if (mesh->vao)
+        glDeleteVertexArrays(1, &mesh->vao);
+    if (mesh->vbo)
+        glDeleteBuffers(1, &mesh->vbo);
+    if (mesh->ebo)
+        glDeleteBuffers(1, &mesh->ebo);
+
+    free(mesh->vertices);
+    free(mesh->indices);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+// copies the staging buffers filled by mesh_build to the gpu
+static void mesh_upload(ChunkMesh* mesh) {
+    if (!upload_ring_ready) {
+        if (!upload_ring_init(&upload_ring, UPLOAD_RING_SIZE))
+            fprintf(stderr, "CHUNK: no buffer storage, uploading with glBufferSubData\n");
+        upload_ring_ready = true;
     }
-    chunk->indices = new_indices;
 
-    unsigned int base = chunk->vertex_count - 4;
+    if (!mesh->vao) mesh_create_buffers(mesh);
+
+    free(mesh->vertices);
+    free(mesh->indices);
+    mesh->vertices = NULL;
+    mesh->indices = NULL;
+
+    // copies keep 32-bit indices, before they are narrowed below
+    if (keep_mesh_data) {
+        mesh->vertices = malloc(sizeof(Vertex) * mesh->vertex_count);
+        mesh->indices = malloc(sizeof(unsigned int) * mesh->index_count);
+        if (!mesh->vertices || !mesh->indices) {
+            fprintf(stderr, "Failed to allocate mesh copy\n");
+            free(mesh->vertices);
+            free(mesh->indices);
+            mesh->vertices = NULL;
+            mesh->indices = NULL;
+        } else {
+            memcpy(mesh->vertices, staging.vertices, sizeof(Vertex) * mesh->vertex_count);
+            memcpy(mesh->indices, staging.indices, sizeof(unsigned int) * mesh->index_count);
+        }
+    }
+
+    // 16-bit indices whenever every vertex is addressable, narrowed in place
+    // since each short lands at or before the int it came from
+    size_t index_size = sizeof(unsigned int);
+    mesh->index_type = GL_UNSIGNED_INT;
+    if (mesh->vertex_count <= 65536) {
+        uint16_t* narrow = (uint16_t*)staging.indices;
+        for (size_t i = 0; i < mesh->index_count; ++i) {
+            narrow[i] = (uint16_t)staging.indices[i];
+        }
+        index_size = sizeof(uint16_t);
+        mesh->index_type = GL_UNSIGNED_SHORT;
+    }
+
+    size_t vertex_bytes = sizeof(Vertex) * mesh->vertex_count;
+    size_t index_bytes = index_size * mesh->index_count;
+
+    mesh_reserve(mesh->vbo, &mesh->vertex_capacity, vertex_bytes);
+    mesh_reserve(mesh->ebo, &mesh->index_capacity, index_bytes);
+    upload_ring_copy(&upload_ring, mesh->vbo, 0, staging.vertices, vertex_bytes);
+    upload_ring_copy(&upload_ring, mesh->ebo, 0, staging.indices, index_bytes);
+}
+
+#define ALL_FACES ((1 << DIR_COUNT) - 1)
+
+// flood fills transparent blocks and records which chunk faces each region touches
+static void chunk_update_connections(Chunk* chunk) {
+    uint16_t stack[MAX_CHUNK_SIZE];
+    uint8_t visited[MAX_CHUNK_SIZE] = {0};
+
+    memset(chunk->face_connections, 0, sizeof(chunk->face_connections));
 
-    chunk->indices[chunk->index_count++] = base;
-    chunk->indices[chunk->index_count++] = base + 1;
-    chunk->indices[chunk->index_count++] = base + 2;
-    chunk->indices[chunk->index_count++] = base + 2;
-    chunk->indices[chunk->index_count++] = base + 3;
-    chunk->indices[chunk->index_count++] = base;
+    for (int start = 0; start < MAX_CHUNK_SIZE; ++start) {
+        if (visited[start] || !block_is_transparent(chunk->blocks[start].type)) continue;
+
+        uint8_t faces = 0;
+        int top = 0;
+        stack[top++] = (uint16_t)start;
+        visited[start] = 1;
+
+        while (top > 0) {
+            int index = stack[--top];
+            int x = index / (CHUNK_SIZE * CHUNK_SIZE);
+            int y = (index / CHUNK_SIZE) % CHUNK_SIZE;
+            int z = index % CHUNK_SIZE;
+
+            if (x == CHUNK_SIZE - 1) faces |= 1 << DIR_POS_X;
+            if (x == 0)              faces |= 1 << DIR_NEG_X;
+            if (y == CHUNK_SIZE - 1) faces |= 1 << DIR_POS_Y;
+            if (y == 0)              faces |= 1 << DIR_NEG_Y;
+            if (z == CHUNK_SIZE - 1) faces |= 1 << DIR_POS_Z;
+            if (z == 0)              faces |= 1 << DIR_NEG_Z;
+
+            for (Direction d = 0; d < DIR_COUNT; ++d) {
+                int next = chunk_get_block_index(x + face_normals[d][0], y + face_normals[d][1], z + face_normals[d][2]);
+                if (next == -1 || visited[next] || !block_is_transparent(chunk->blocks[next].type)) continue;
+
+                visited[next] = 1;
+                stack[top++] = (uint16_t)next;
+            }
+        }
+
+        // every face touched by the region can see every other one
+        for (Direction d = 0; d < DIR_COUNT; ++d) {
+            if (faces & (1 << d)) chunk->face_connections[d] |= faces;
+        }
+    }
+}
+
+// finds a layer of opaque blocks spanning the whole chunk along each axis,
+// the renderer uses them as occluders for the software occlusion buffer
+static void chunk_update_occluders(Chunk* chunk) {
+    for (int axis = 0; axis < 3; ++axis) {
+        chunk->occluder_layer[axis] = -1;
+
+        for (int layer = 0; layer < CHUNK_SIZE && chunk->occluder_layer[axis] == -1; ++layer) {
+            bool solid = true;
+            for (int u = 0; u < CHUNK_SIZE && solid; ++u) {
+                for (int v = 0; v < CHUNK_SIZE && solid; ++v) {
+                    int pos[3];
+                    pos[axis] = layer;
+                    pos[(axis + 1) % 3] = u;
+                    pos[(axis + 2) % 3] = v;
+
+                    BlockType type = chunk->blocks[chunk_get_block_index(pos[0], pos[1], pos[2])].type;
+                    if (block_is_transparent(type)) solid = false;
+                }
+            }
+            if (solid) chunk->occluder_layer[axis] = (int8_t)layer;
+        }
+    }
+}
+
+// faces of a direction can only be front facing if the camera is on their side of the chunk
+static bool face_range_visible(Direction dir, const vec3 camera, float y_min, float y_max) {
+    const float box_min = -0.5f;
+    const float box_max = CHUNK_SIZE - 0.5f;
+
+    switch (dir) {
+        case DIR_POS_X: return camera[0] > box_min;
+        case DIR_NEG_X: return camera[0] < box_max;
+        case DIR_POS_Y: return camera[1] > y_min;
+        case DIR_NEG_Y: return camera[1] < y_max;
+        case DIR_POS_Z: return camera[2] > box_min;
+        case DIR_NEG_Z: return camera[2] < box_max;
+        default: return true;
+    }
 }
 
 int chunk_get_block_index(int x, int y, int z) {
@@ -135,7 +409,113 @@ void chunk_set_block(Chunk* chunk, int x, int y, int z, BlockType block) {
         z < 0 || z >= CHUNK_SIZE) {
         return;
     }
-    chunk->blocks[chunk_get_block_index(x, y, z)].type = block;
+    Block* target = &chunk->blocks[chunk_get_block_index(x, y, z)];
+    if (block_is_transparent(target->type) != block_is_transparent(block)) chunk->shape_dirty = true;
+    target->type = block;
+    chunk->generation++;
+    chunk_mark_dirty(chunk, y);
+}
+
+void chunk_mark_dirty(Chunk* chunk, int y) {
+    int section = y / CHUNK_SECTION_SIZE;
+    chunk->dirty_sections |= 1 << section;
+
+    // faces of the block above or below are stored in the next section
+    if (y % CHUNK_SECTION_SIZE == 0 && section > 0)
+        chunk->dirty_sections |= 1 << (section - 1);
+    if (y % CHUNK_SECTION_SIZE == CHUNK_SECTION_SIZE - 1 && section < CHUNK_SECTION_COUNT - 1)
+        chunk->dirty_sections |= 1 << (section + 1);
+}
+
+void chunk_mark_dirty_range(Chunk* chunk, int y_begin, int y_end) {
+    if (y_begin < 0) y_begin = 0;
+    if (y_end > CHUNK_SIZE) y_end = CHUNK_SIZE;
+    if (y_begin >= y_end) return;
+
+    for (int s = y_begin / CHUNK_SECTION_SIZE; s <= (y_end - 1) / CHUNK_SECTION_SIZE; s++) {
+        chunk->dirty_sections |= 1 << s;
+    }
+    // only the end layers can reach into sections outside the range
+    chunk_mark_dirty(chunk, y_begin);
+    chunk_mark_dirty(chunk, y_end - 1);
+}
+
+static inline int clamp_to_chunk(int v) {
+    return v < 0 ? 0 : (v > CHUNK_SIZE ? CHUNK_SIZE : v);
+}
+
+void chunk_blocks_fill_box(Block* blocks, int x0, int y0, int z0, int x1, int y1, int z1, BlockType type) {
+    x0 = clamp_to_chunk(x0); y0 = clamp_to_chunk(y0); z0 = clamp_to_chunk(z0);
+    x1 = clamp_to_chunk(x1); y1 = clamp_to_chunk(y1); z1 = clamp_to_chunk(z1);
+
+    for (int x = x0; x < x1; x++) {
+        for (int y = y0; y < y1; y++) {
+            Block* row = &blocks[x * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE];
+            for (int z = z0; z < z1; z++) {
+                row[z].type = type;
+            }
+        }
+    }
+}
+
+void chunk_blocks_set_column(Block* blocks, int x, int z, int y0, const BlockType* types, int count) {
+    if (x < 0 || x >= CHUNK_SIZE || z < 0 || z >= CHUNK_SIZE) return;
+
+    int begin = y0 < 0 ? -y0 : 0;
+    int end = y0 + count > CHUNK_SIZE ? CHUNK_SIZE - y0 : count;
+    Block* column = &blocks[x * CHUNK_SIZE * CHUNK_SIZE + z];
+    for (int i = begin; i < end; i++) {
+        column[(y0 + i) * CHUNK_SIZE].type = types[i];
+    }
+}
+
+void chunk_blocks_copy_span(Block* blocks, int x0, int y0, int z0, int size_x, int size_y, int size_z, const Block* src) {
+    // clip against the chunk, the source keeps its own strides
+    int bx = x0 < 0 ? -x0 : 0, ex = clamp_to_chunk(x0 + size_x) - x0;
+    int by = y0 < 0 ? -y0 : 0, ey = clamp_to_chunk(y0 + size_y) - y0;
+    int bz = z0 < 0 ? -z0 : 0, ez = clamp_to_chunk(z0 + size_z) - z0;
+    if (bz >= ez) return;
+
+    // z is contiguous on both sides, so every row is a single copy
+    size_t row_size = (size_t)(ez - bz) * sizeof(Block);
+    for (int x = bx; x < ex; x++) {
+        for (int y = by; y < ey; y++) {
+            memcpy(&blocks[chunk_get_block_index(x0 + x, y0 + y, z0 + bz)],
+                   &src[((size_t)x * size_y + y) * size_z + bz], row_size);
+        }
+    }
+}
+
+void chunk_fill_box(Chunk* chunk, int x0, int y0, int z0, int x1, int y1, int z1, BlockType type) {
+    if (x0 >= x1 || z0 >= z1) return;
+    chunk_blocks_fill_box(chunk->blocks, x0, y0, z0, x1, y1, z1, type);
+    chunk->generation++;
+    chunk->shape_dirty = true;
+    chunk_mark_dirty_range(chunk, y0, y1);
+}
+
+void chunk_set_column(Chunk* chunk, int x, int z, int y0, const BlockType* types, int count) {
+    if (x < 0 || x >= CHUNK_SIZE || z < 0 || z >= CHUNK_SIZE) return;
+    chunk_blocks_set_column(chunk->blocks, x, z, y0, types, count);
+    chunk->generation++;
+    chunk->shape_dirty = true;
+    chunk_mark_dirty_range(chunk, y0, y0 + count);
+}
+
+void chunk_copy_span(Chunk* chunk, int x0, int y0, int z0, int size_x, int size_y, int size_z, const Block* src) {
+    if (size_x <= 0 || size_z <= 0) return;
+    chunk_blocks_copy_span(chunk->blocks, x0, y0, z0, size_x, size_y, size_z, src);
+    chunk->generation++;
+    chunk->shape_dirty = true;
+    chunk_mark_dirty_range(chunk, y0, y0 + size_y);
+}
+
+size_t chunk_index_count(const Chunk* chunk) {
+    size_t count = 0;
+    for (int s = 0; s < CHUNK_SECTION_COUNT; s++) {
+        count += chunk->sections[s].index_count;
+    }
+    return count;
 }
 
 void chunk_init(Chunk* chunk, int index) {
@@ -147,239 +527,166 @@ void chunk_init(Chunk* chunk, int index) {
         chunk->blocks[i].light_level = 0;
     }
 
-    chunk->blocks[chunk_get_block_index(0, 1, 0)].type = BLOCK_LIGHT;
-    
+    // blocks and their initial light come from the generator, see chunk_gen.c
     lightqueue_init(&chunk->light_queue);
     lightqueue_init(&chunk->border_light_queue);
 
-    // lightqueue_push(&chunk->light_queue, (LightNode){0, 1, 0, 15});
-	
-    chunk->vertices = NULL;
-    chunk->indices = NULL;
-    chunk->vertex_count = 0;
-    chunk->index_count = 0;
-
-	chunk->vao = chunk->vbo = chunk->ebo = 0;
-	glGenVertexArrays(1, &chunk->vao);
-    glGenBuffers(1, &chunk->vbo);
-	glGenBuffers(1, &chunk->ebo);
+    for (int s = 0; s < CHUNK_SECTION_COUNT; s++) {
+        mesh_init(&chunk->sections[s]);
+    }
+    for (int lod = 1; lod < CHUNK_LOD_COUNT; lod++) {
+        mesh_init(&chunk->lods[lod - 1]);
+    }
+    chunk->lod_valid = 0;
+    chunk->dirty_sections = 0;
+    memset(chunk->face_connections, ALL_FACES, sizeof(chunk->face_connections));
+    memset(chunk->occluder_layer, -1, sizeof(chunk->occluder_layer));
 
 	chunk->dirty = true;
 	chunk->visible = false;
     chunk->active = true;
-
-    // seed light
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_SIZE; y++) {
-            for (int z = 0; z < CHUNK_SIZE; z++) {
-                Block* block = &chunk->blocks[chunk_get_block_index(x, y, z)];
-                if (block->type == BLOCK_LIGHT) {
-                    int ch_x = index % WORLD_SIZE_X;
-                    int ch_y = (index / WORLD_SIZE_X) % WORLD_SIZE_Y;
-                    int ch_z = index / (WORLD_SIZE_X * WORLD_SIZE_Y);
-
-                    uint8_t emission = block_get_emission(block->type);
-                    block->light_level = emission;
-
-                    lightqueue_push(
-                        &chunk->light_queue,
-                        (LightNode){
-                            x + (ch_x * CHUNK_SIZE),
-                            y + (ch_y * CHUNK_SIZE),
-                            z + (ch_z * CHUNK_SIZE),
-                            emission
-                        }
-                    );
-                }
-            }
-        }
-    }
 }
 
 void chunk_unload(Chunk* chunk) {
-    if (chunk->vao)
-        glDeleteVertexArrays(1, &chunk->vao);
-    if (chunk->vbo)
-        glDeleteBuffers(1, &chunk->vbo);
-    if (chunk->ebo)
-        glDeleteBuffers(1, &chunk->ebo);
-
-    chunk->vao = 0;
-    chunk->vbo = 0;
-    chunk->ebo = 0;
+    for (int s = 0; s < CHUNK_SECTION_COUNT; s++) {
+        mesh_free(&chunk->sections[s]);
+    }
+    for (int lod = 1; lod < CHUNK_LOD_COUNT; lod++) {
+        mesh_free(&chunk->lods[lod - 1]);
+    }
+    chunk->lod_valid = 0;
 
     free(chunk->blocks);
-    free(chunk->vertices);
-    free(chunk->indices);
 }
 
 void chunk_update_mesh(World* world, Chunk* chunk, int ch_x, int ch_y, int ch_z) {
     // chunk_update_light(world, chunk, (ivec3){ch_x, ch_y, ch_z});
 
-	free(chunk->vertices);
-    free(chunk->indices);
-    chunk->vertices = NULL;
-    chunk->indices = NULL;
-    chunk->vertex_count = 0;
-    chunk->index_count = 0;
-
 	Chunk* neighbors[DIR_COUNT] = {0};
 	for (Direction d = 0; d < DIR_COUNT; ++d) {
 		neighbors[d] = chunk_get_neighbor(world, ch_x, ch_y, ch_z, d);
 	}
 
-	for (int x = 0; x < CHUNK_SIZE; ++x) {
-   		for (int y = 0; y < CHUNK_SIZE; ++y) {
-        	for (int z = 0; z < CHUNK_SIZE; ++z) {
-				BlockType bt = chunk->blocks[chunk_get_block_index(x, y, z)].type;
-                uint8_t light_level = chunk->blocks[chunk_get_block_index(x, y, z)].light_level;
-            	if (bt == BLOCK_AIR) continue;
-
-            	vec3 posf = { (float)x, (float)y, (float)z };
-
-                // +X
-                if (x == CHUNK_SIZE - 1) {
-                    Block *neighbor = neighbors[DIR_POS_X]
-                        ? &neighbors[DIR_POS_X]->blocks[chunk_get_block_index(0, y, z)]
-                        : NULL;
-                    BlockType nb = neighbor ? neighbor->type : BLOCK_AIR;
-                    uint8_t neighbor_light = neighbor ? neighbor->light_level : 0;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_POS_X, bt, neighbor_light);
-                } else {
-                    Block *neighbor = &chunk->blocks[chunk_get_block_index(x + 1, y, z)];
-                    BlockType nb = neighbor->type;
-                    uint8_t neighbor_light = neighbor->light_level;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_POS_X, bt, neighbor_light);
-                }
-
-                // -X
-                if (x == 0) {
-                    Block *neighbor = neighbors[DIR_NEG_X]
-                        ? &neighbors[DIR_NEG_X]->blocks[chunk_get_block_index(CHUNK_SIZE - 1, y, z)]
-                        : NULL;
-                    BlockType nb = neighbor ? neighbor->type : BLOCK_AIR;
-                    uint8_t neighbor_light = neighbor ? neighbor->light_level : 0;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_NEG_X, bt, neighbor_light);
-                } else {
-                    Block *neighbor = &chunk->blocks[chunk_get_block_index(x - 1, y, z)];
-                    BlockType nb = neighbor->type;
-                    uint8_t neighbor_light = neighbor->light_level;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_NEG_X, bt, neighbor_light);
+    // a full rebuild touches every section
+    uint8_t sections = chunk->dirty ? (1 << CHUNK_SECTION_COUNT) - 1 : chunk->dirty_sections;
+    if (!sections) return;
+
+    int first = 0;
+    int last = CHUNK_SECTION_COUNT - 1;
+    while (!(sections & (1 << first))) first++;
+    while (!(sections & (1 << last))) last--;
+
+    // copy the dirty layers, the layer around them, and the touching layer of each neighbor into one grid
+    MeshGrid grid;
+    int y_begin = first * CHUNK_SECTION_SIZE - 1;
+    int y_end = (last + 1) * CHUNK_SECTION_SIZE;
+    for (int x = -1; x <= CHUNK_SIZE; ++x) {
+        for (int y = y_begin; y <= y_end; ++y) {
+            for (int z = -1; z <= CHUNK_SIZE; ++z) {
+                int outside = (x < 0 || x >= CHUNK_SIZE) + (y < 0 || y >= CHUNK_SIZE) + (z < 0 || z >= CHUNK_SIZE);
+                const Block* block = NULL;
+
+                if (outside == 0) {
+                    block = &chunk->blocks[chunk_get_block_index(x, y, z)];
+                } else if (outside == 1) { // edges and corners are never sampled
+                    Direction d = x < 0 ? DIR_NEG_X : x >= CHUNK_SIZE ? DIR_POS_X
+                                : y < 0 ? DIR_NEG_Y : y >= CHUNK_SIZE ? DIR_POS_Y
+                                : z < 0 ? DIR_NEG_Z : DIR_POS_Z;
+                    if (neighbors[d]) {
+                        block = &neighbors[d]->blocks[chunk_get_block_index(
+                            (x + CHUNK_SIZE) % CHUNK_SIZE,
+                            (y + CHUNK_SIZE) % CHUNK_SIZE,
+                            (z + CHUNK_SIZE) % CHUNK_SIZE
+                        )];
+                    }
                 }
 
-                // +Y
-                if (y == CHUNK_SIZE - 1) {
-                    Block *neighbor = neighbors[DIR_POS_Y]
-                        ? &neighbors[DIR_POS_Y]->blocks[chunk_get_block_index(x, 0, z)]
-                        : NULL;
-                    BlockType nb = neighbor ? neighbor->type : BLOCK_AIR;
-                    uint8_t neighbor_light = neighbor ? neighbor->light_level : 0;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_POS_Y, bt, neighbor_light);
-                } else {
-                    Block *neighbor = &chunk->blocks[chunk_get_block_index(x, y + 1, z)];
-                    BlockType nb = neighbor->type;
-                    uint8_t neighbor_light = neighbor->light_level;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_POS_Y, bt, neighbor_light);
-                }
-
-                // -Y
-                if (y == 0) {
-                    Block *neighbor = neighbors[DIR_NEG_Y]
-                        ? &neighbors[DIR_NEG_Y]->blocks[chunk_get_block_index(x, CHUNK_SIZE - 1, z)]
-                        : NULL;
-                    BlockType nb = neighbor ? neighbor->type : BLOCK_AIR;
-                    uint8_t neighbor_light = neighbor ? neighbor->light_level : 0;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_NEG_Y, bt, neighbor_light);
-                } else {
-                    Block *neighbor = &chunk->blocks[chunk_get_block_index(x, y - 1, z)];
-                    BlockType nb = neighbor->type;
-                    uint8_t neighbor_light = neighbor->light_level;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_NEG_Y, bt, neighbor_light);
-                }
+                grid.type[grid_index(x, y, z)] = block ? block->type : BLOCK_AIR;
+                grid.light[grid_index(x, y, z)] = block ? block->light_level : 0;
+            }
+        }
+    }
 
-                // +Z
-                if (z == CHUNK_SIZE - 1) {
-                    Block *neighbor = neighbors[DIR_POS_Z]
-                        ? &neighbors[DIR_POS_Z]->blocks[chunk_get_block_index(x, y, 0)]
-                        : NULL;
-                    BlockType nb = neighbor ? neighbor->type : BLOCK_AIR;
-                    uint8_t neighbor_light = neighbor ? neighbor->light_level : 0;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_POS_Z, bt, neighbor_light);
-                } else {
-                    Block *neighbor = &chunk->blocks[chunk_get_block_index(x, y, z + 1)];
-                    BlockType nb = neighbor->type;
-                    uint8_t neighbor_light = neighbor->light_level;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_POS_Z, bt, neighbor_light);
-                }
+    for (int s = first; s <= last; ++s) {
+        if (!(sections & (1 << s))) continue;
 
-                // -Z
-                if (z == 0) {
-                    Block *neighbor = neighbors[DIR_NEG_Z]
-                        ? &neighbors[DIR_NEG_Z]->blocks[chunk_get_block_index(x, y, CHUNK_SIZE - 1)]
-                        : NULL;
-                    BlockType nb = neighbor ? neighbor->type : BLOCK_AIR;
-                    uint8_t neighbor_light = neighbor ? neighbor->light_level : 0;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_NEG_Z, bt, neighbor_light);
-                } else {
-                    Block *neighbor = &chunk->blocks[chunk_get_block_index(x, y, z - 1)];
-                    BlockType nb = neighbor->type;
-                    uint8_t neighbor_light = neighbor->light_level;
-
-                    if (nb == BLOCK_AIR || nb != bt)
-                        add_face(chunk, posf, DIR_NEG_Z, bt, neighbor_light);
-                }
-        	}
-		}
+        mesh_build(&chunk->sections[s], &grid, CHUNK_SIZE, s * CHUNK_SECTION_SIZE, (s + 1) * CHUNK_SECTION_SIZE, 1);
+        mesh_upload(&chunk->sections[s]);
     }
 
-    glBindVertexArray(chunk->vao);
-
-    glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * chunk->vertex_count, chunk->vertices, GL_DYNAMIC_DRAW);
+    // both scan the whole chunk, edits that keep every block as see-through
+    // or as solid as before leave them as they are
+    if (chunk->dirty || chunk->shape_dirty) {
+        chunk_update_connections(chunk);
+        chunk_update_occluders(chunk);
+        chunk->shape_dirty = false;
+    }
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(vec3)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(vec3) + sizeof(vec2)));
-    glEnableVertexAttribArray(2);
+    // coarser levels are rebuilt when the renderer asks for them
+    chunk->lod_valid = 1;
+    chunk->dirty_sections = 0;
+	chunk->dirty = false;
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * chunk->index_count, chunk->indices, GL_DYNAMIC_DRAW);
+void chunk_update_lod_mesh(Chunk* chunk, int lod) {
+    int scale = 1 << lod;
+    int size = CHUNK_SIZE / scale;
+
+    // the border stays empty so faces at chunk edges are always emitted,
+    // neighbors may be drawn at another level and must not leave holes
+    MeshGrid grid;
+    memset(&grid, 0, sizeof(grid));
+
+    for (int cx = 0; cx < size; ++cx) {
+        for (int cy = 0; cy < size; ++cy) {
+            for (int cz = 0; cz < size; ++cz) {
+                BlockType top = BLOCK_AIR;
+                uint8_t light = 0;
+                int filled = 0;
+
+                // scan from the top so the cell shows its surface block
+                for (int y = scale - 1; y >= 0; --y) {
+                    for (int x = 0; x < scale; ++x) {
+                        for (int z = 0; z < scale; ++z) {
+                            const Block* block = &chunk->blocks[chunk_get_block_index(
+                                cx * scale + x, cy * scale + y, cz * scale + z)];
+
+                            if (block->light_level > light) light = block->light_level;
+                            if (block->type == BLOCK_AIR) continue;
+
+                            if (top == BLOCK_AIR) top = block->type;
+                            filled++;
+                        }
+                    }
+                }
 
-    glBindVertexArray(0);
+                // solid once it holds a full layer worth of blocks, so thin floors survive
+                grid.type[grid_index(cx, cy, cz)] = filled >= scale * scale ? top : BLOCK_AIR;
+                grid.light[grid_index(cx, cy, cz)] = light;
+
+                // border cells take the light of the cell they touch so edge faces are not black
+                for (Direction d = 0; d < DIR_COUNT; ++d) {
+                    int nx = cx + face_normals[d][0];
+                    int ny = cy + face_normals[d][1];
+                    int nz = cz + face_normals[d][2];
+                    if (nx < 0 || ny < 0 || nz < 0 || nx >= size || ny >= size || nz >= size)
+                        grid.light[grid_index(nx, ny, nz)] = light;
+                }
+            }
+        }
+    }
 
-	chunk->dirty = false;
+    mesh_build(&chunk->lods[lod - 1], &grid, size, 0, size, scale);
+    mesh_upload(&chunk->lods[lod - 1]);
+    chunk->lod_valid |= 1 << lod;
 }
 
 void chunk_update_light(World* world, Chunk* chunk, int index) {
     if (!chunk || !chunk->blocks) return;
 
-    int ch_x = index % WORLD_SIZE_X;
-    int ch_y = (index / WORLD_SIZE_X) % WORLD_SIZE_Y;
-    int ch_z = index / (WORLD_SIZE_X * WORLD_SIZE_Y);
+    int ch_x = index / (WORLD_SIZE_Y * WORLD_SIZE_Z);
+    int ch_y = (index / WORLD_SIZE_Z) % WORLD_SIZE_Y;
+    int ch_z = index % WORLD_SIZE_Z;
 
     // Process border light queue
     while (!lightqueue_empty(&chunk->border_light_queue)) {
@@ -462,9 +769,59 @@ void chunk_update_light(World* world, Chunk* chunk, int index) {
     }
 }
 
-void chunk_draw(const Chunk* chunk, Shader* shader) {
-	glBindVertexArray(chunk->vao);
-	glDrawElements(GL_TRIANGLES, (GLsizei)chunk->index_count, GL_UNSIGNED_INT, 0);
+// y_min and y_max bound the mesh vertically, relative to the chunk origin
+static void mesh_draw(const ChunkMesh* mesh, const vec3 camera, MeshPass pass, float y_min, float y_max) {
+    GLsizei counts[DIR_COUNT];
+    const void* offsets[DIR_COUNT];
+    GLsizei draw_count = 0;
+    size_t last_end = 0;
+    size_t index_size = mesh->index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+
+    for (Direction d = 0; d < DIR_COUNT; ++d) {
+        size_t offset = mesh->face_offset[pass][d];
+        size_t count = mesh->face_count[pass][d];
+        if (count == 0 || !face_range_visible(d, camera, y_min, y_max)) continue;
+
+        // merge with the previous range when they are contiguous
+        if (draw_count > 0 && last_end == offset) {
+            counts[draw_count - 1] += (GLsizei)count;
+        } else {
+            counts[draw_count] = (GLsizei)count;
+            offsets[draw_count] = (const void*)(offset * index_size);
+            draw_count++;
+        }
+        last_end = offset + count;
+    }
+    if (draw_count == 0) return;
+
+	glBindVertexArray(mesh->vao);
+	glMultiDrawElements(GL_TRIANGLES, counts, mesh->index_type, offsets, draw_count);
 	glBindVertexArray(0);
 }
 
+static bool mesh_has_pass(const ChunkMesh* mesh, MeshPass pass) {
+    for (Direction d = 0; d < DIR_COUNT; ++d) {
+        if (mesh->face_count[pass][d] > 0) return true;
+    }
+    return false;
+}
+
+bool chunk_has_pass(const Chunk* chunk, MeshPass pass, int lod) {
+    if (lod > 0) return mesh_has_pass(&chunk->lods[lod - 1], pass);
+    for (int s = 0; s < CHUNK_SECTION_COUNT; ++s) {
+        if (mesh_has_pass(&chunk->sections[s], pass)) return true;
+    }
+    return false;
+}
+
+void chunk_draw(const Chunk* chunk, Shader* shader, const vec3 camera, MeshPass pass, int lod) {
+    if (lod > 0) {
+        mesh_draw(&chunk->lods[lod - 1], camera, pass, -0.5f, CHUNK_SIZE - 0.5f);
+        return;
+    }
+
+    for (int s = 0; s < CHUNK_SECTION_COUNT; ++s) {
+        float y_min = s * CHUNK_SECTION_SIZE - 0.5f;
+        mesh_draw(&chunk->sections[s], camera, pass, y_min, y_min + CHUNK_SECTION_SIZE);
+    }
+}
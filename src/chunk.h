@@ -13,6 +13,9 @@ typedef struct World World;
 
 #define CHUNK_SIZE 16
 #define MAX_CHUNK_SIZE (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+#define CHUNK_LOD_COUNT 4 // full detail, then 2x, 4x and 8x downsampled
+#define CHUNK_SECTION_SIZE 4 // height of the slabs the full detail mesh is split into
+#define CHUNK_SECTION_COUNT (CHUNK_SIZE / CHUNK_SECTION_SIZE)
 
 typedef enum {
 	DIR_POS_X = 0,	// +X
@@ -24,26 +27,53 @@ typedef enum {
 	DIR_COUNT = 6	// COUNT
 } Direction;
 
+typedef enum {
+	MESH_PASS_OPAQUE = 0,      // drawn front to back with depth writes
+	MESH_PASS_TRANSLUCENT = 1, // drawn back to front with blending
+	MESH_PASS_COUNT = 2
+} MeshPass;
+
 typedef struct {
 	vec3 position;
-	vec2 uv;
+	vec2 uv;       // in blocks, repeats across larger faces
     float light;
+	float layer;   // texture array layer
 } Vertex;
 
+typedef struct {
+	Vertex* vertices;      // cpu copy, NULL unless chunk_set_keep_mesh_data is on
+	unsigned int* indices;  // always 32-bit, even when the gpu copy is not
+	size_t vertex_count;
+	size_t index_count;
+	size_t face_offset[MESH_PASS_COUNT][DIR_COUNT]; // first index of each pass and direction
+	size_t face_count[MESH_PASS_COUNT][DIR_COUNT];  // index count of each pass and direction
+	size_t vertex_capacity; // bytes of gpu storage, grown but never shrunk
+	size_t index_capacity;
+	GLenum index_type; // GL_UNSIGNED_SHORT when vertex_count allows, else GL_UNSIGNED_INT
+
+	GLuint vao;
+	GLuint vbo;
+	GLuint ebo;
+} ChunkMesh;
+
 typedef struct Chunk {
 	Block* blocks;
 
-	Vertex* vertices;
-	unsigned int* indices;
-	size_t vertex_count;
-	size_t index_count;
+	ChunkMesh sections[CHUNK_SECTION_COUNT]; // full detail mesh, rebuilt per slab on edits
+	ChunkMesh lods[CHUNK_LOD_COUNT - 1];     // lods[i] is level i + 1
+	uint8_t lod_valid;                       // bit per level whose mesh matches the blocks
+	uint8_t dirty_sections;                  // bit per section to rebuild, dirty rebuilds all
+
+	uint8_t face_connections[DIR_COUNT]; // bitmask of faces reachable from each face through transparent blocks
+	int8_t occluder_layer[3]; // a fully opaque layer across each axis, -1 if none
+	bool shape_dirty;         // a block turned transparent or solid, both above are stale
 
     LightQueue light_queue;
     LightQueue border_light_queue;
 
-	GLuint vao;
-	GLuint vbo;
-	GLuint ebo;
+	uint32_t generation;        // bumped by every block edit
+	uint32_t saved_generation;  // generation last written to disk
+	uint32_t queued_generation; // generation of the save waiting on the io thread
 
 	bool dirty;
 	bool visible;
@@ -53,12 +83,32 @@ typedef struct Chunk {
 int chunk_get_block_index(int x, int y, int z);
 BlockType chunk_get_block(Chunk* chunk, int x, int y, int z);
 void chunk_set_block(Chunk* chunk, int x, int y, int z, BlockType block);
+void chunk_mark_dirty(Chunk* chunk, int y); // sections showing faces of blocks in layer y
+void chunk_mark_dirty_range(Chunk* chunk, int y_begin, int y_end); // layers [y_begin, y_end)
+
+// bulk writes straight into block storage, boxes are half-open [min, max) in
+// chunk coordinates and clipped to the chunk; fills and columns only change
+// the type, spans copy whole blocks including light
+void chunk_blocks_fill_box(Block* blocks, int x0, int y0, int z0, int x1, int y1, int z1, BlockType type);
+void chunk_blocks_set_column(Block* blocks, int x, int z, int y0, const BlockType* types, int count);
+void chunk_blocks_copy_span(Block* blocks, int x0, int y0, int z0, int size_x, int size_y, int size_z, const Block* src); // src is [x][y][z]
+
+// the same, but on a live chunk whose mesh has to follow
+void chunk_fill_box(Chunk* chunk, int x0, int y0, int z0, int x1, int y1, int z1, BlockType type);
+void chunk_set_column(Chunk* chunk, int x, int z, int y0, const BlockType* types, int count);
+void chunk_copy_span(Chunk* chunk, int x0, int y0, int z0, int size_x, int size_y, int size_z, const Block* src);
+size_t chunk_index_count(const Chunk* chunk); // full detail
+
+void chunk_set_keep_mesh_data(bool keep); // keep cpu copies of meshes built from now on
+void chunk_free_staging(void);
 
 void chunk_init(Chunk* chunk, int index);
 void chunk_unload(Chunk* chunk);
-void chunk_update_mesh(World* world, Chunk* chunk, int cx, int cy, int cz); // update mesh
+void chunk_update_mesh(World* world, Chunk* chunk, int cx, int cy, int cz); // rebuild dirty sections
+void chunk_update_lod_mesh(Chunk* chunk, int lod); // downsampled mesh, lod > 0
 void chunk_update_light(World* world, Chunk* chunk, int index); // update light
-void chunk_draw(const Chunk* chunk, Shader* shader);
+bool chunk_has_pass(const Chunk* chunk, MeshPass pass, int lod); // any indices to draw in the pass
+void chunk_draw(const Chunk* chunk, Shader* shader, const vec3 camera, MeshPass pass, int lod); // camera relative to chunk origin
 
 #endif
 
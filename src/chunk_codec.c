@@ -0,0 +1,164 @@
+#include "chunk_codec.h"
+
+#include <string.h>
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    bool overflow;
+} CodecWriter;
+
+static inline void codec_put(CodecWriter* w, uint8_t byte) {
+    if (w->size < w->capacity) w->data[w->size++] = byte;
+    else w->overflow = true;
+}
+
+static void codec_put_varint(CodecWriter* w, uint32_t value) {
+    while (value >= 0x80) {
+        codec_put(w, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    codec_put(w, (uint8_t)value);
+}
+
+static inline bool codec_get_varint(const uint8_t* data, size_t size, size_t* pos, uint32_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+        if (*pos >= size) return false;
+        uint8_t byte = data[(*pos)++];
+        *value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// runs are taken layer by layer, y outermost, where terrain is most uniform;
+// returns the storage index of the p-th block in that order
+static inline int codec_layer_order(int p) {
+    return ((p >> 4) & (CHUNK_SIZE - 1)) * CHUNK_SIZE * CHUNK_SIZE + (p >> 8) * CHUNK_SIZE + (p & (CHUNK_SIZE - 1));
+}
+
+static void codec_put_runs(CodecWriter* w, const uint8_t* values, int count) {
+    int i = 0;
+    while (i < count) {
+        int run = 1;
+        while (i + run < count && values[i + run] == values[i]) run++;
+        codec_put_varint(w, (uint32_t)(run - 1));
+        codec_put(w, values[i]);
+        i += run;
+    }
+}
+
+static size_t codec_encode_body(const Block* blocks, uint8_t* out, size_t capacity) {
+    CodecWriter w = { out, 0, capacity, false };
+
+    // palette in order of first appearance
+    uint16_t palette_index[256];
+    uint8_t palette[256];
+    int palette_size = 0;
+    memset(palette_index, 0xff, sizeof(palette_index));
+
+    uint8_t indices[MAX_CHUNK_SIZE];
+    for (int i = 0; i < MAX_CHUNK_SIZE; i++) {
+        uint8_t type = (uint8_t)blocks[codec_layer_order(i)].type;
+        if (palette_index[type] == 0xffff) {
+            palette_index[type] = (uint16_t)palette_size;
+            palette[palette_size++] = type;
+        }
+        indices[i] = (uint8_t)palette_index[type];
+    }
+
+    codec_put(&w, (uint8_t)(palette_size - 1));
+    for (int i = 0; i < palette_size; i++) codec_put(&w, palette[i]);
+    codec_put_runs(&w, indices, MAX_CHUNK_SIZE);
+
+    uint8_t light[CHUNK_CODEC_LIGHT_SIZE];
+    for (int i = 0; i < CHUNK_CODEC_LIGHT_SIZE; i++) {
+        const Block* pair = &blocks[codec_layer_order(2 * i)]; // z neighbors
+        light[i] = (uint8_t)((pair[0].light_level & 15) | (pair[1].light_level & 15) << 4);
+    }
+    codec_put_runs(&w, light, CHUNK_CODEC_LIGHT_SIZE);
+
+    return w.overflow ? 0 : w.size;
+}
+
+size_t chunk_codec_encode(const Block* blocks, uint8_t* out, size_t capacity, bool compress) {
+    uint8_t body[CHUNK_CODEC_BODY_MAX];
+    size_t body_size = codec_encode_body(blocks, body, sizeof(body));
+    if (!body_size) return 0;
+
+    if (compress && capacity > 5) {
+        size_t packed = lz_compress(body, body_size, out + 5, capacity - 5);
+        if (packed && packed + 4 < body_size) {
+            out[0] = CHUNK_CODEC_LZ;
+            for (int i = 0; i < 4; i++) out[1 + i] = (uint8_t)(body_size >> (i * 8));
+            return 5 + packed;
+        }
+    }
+
+    if (capacity < body_size + 1) return 0;
+    out[0] = 0;
+    memcpy(out + 1, body, body_size);
+    return body_size + 1;
+}
+
+// reads the run starting at pos, false if it is malformed or longer than remaining
+static inline bool codec_get_run(const uint8_t* data, size_t size, size_t* pos, int remaining, int* run, uint8_t* value) {
+    uint32_t run_minus_one;
+    if (!codec_get_varint(data, size, pos, &run_minus_one) || *pos >= size) return false;
+    if (run_minus_one >= (uint32_t)remaining) return false;
+    *run = (int)run_minus_one + 1;
+    *value = data[(*pos)++];
+    return true;
+}
+
+static bool codec_decode_body(const uint8_t* data, size_t size, Block* blocks) {
+    size_t pos = 0;
+    if (size < 1) return false;
+    int palette_size = data[pos++] + 1;
+    if (size - pos < (size_t)palette_size) return false;
+
+    BlockType palette[256];
+    for (int i = 0; i < palette_size; i++) {
+        uint8_t type = data[pos++];
+        palette[i] = type < BLOCK_TYPE_COUNT ? (BlockType)type : BLOCK_AIR;
+    }
+
+    // expand the runs in layer order, then scatter them into storage
+    uint8_t values[MAX_CHUNK_SIZE];
+    int run;
+    uint8_t value;
+    for (int i = 0; i < MAX_CHUNK_SIZE; i += run) {
+        if (!codec_get_run(data, size, &pos, MAX_CHUNK_SIZE - i, &run, &value) || value >= palette_size) return false;
+        memset(values + i, value, run);
+    }
+    for (int i = 0; i < MAX_CHUNK_SIZE; i++) {
+        blocks[codec_layer_order(i)].type = palette[values[i]];
+    }
+
+    for (int i = 0; i < CHUNK_CODEC_LIGHT_SIZE; i += run) {
+        if (!codec_get_run(data, size, &pos, CHUNK_CODEC_LIGHT_SIZE - i, &run, &value)) return false;
+        memset(values + i, value, run);
+    }
+    for (int i = 0; i < CHUNK_CODEC_LIGHT_SIZE; i++) {
+        Block* pair = &blocks[codec_layer_order(2 * i)];
+        pair[0].light_level = values[i] & 15;
+        pair[1].light_level = values[i] >> 4;
+    }
+
+    return pos == size;
+}
+
+bool chunk_codec_decode(const uint8_t* data, size_t size, Block* blocks) {
+    if (size < 1) return false;
+    if (!(data[0] & CHUNK_CODEC_LZ)) return codec_decode_body(data + 1, size - 1, blocks);
+
+    if (size < 5) return false;
+    size_t body_size = (size_t)data[1] | (size_t)data[2] << 8 | (size_t)data[3] << 16 | (size_t)data[4] << 24;
+    if (body_size > CHUNK_CODEC_BODY_MAX) return false;
+
+    uint8_t body[CHUNK_CODEC_BODY_MAX];
+    if (!lz_decompress(data + 5, size - 5, body, body_size)) return false;
+    return codec_decode_body(body, body_size, blocks);
+}
@@ -0,0 +1,28 @@
+#ifndef CHUNK_CODEC_H
+#define CHUNK_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "block.h"
+#include "chunk.h"
+#include "lz.h"
+
+// serialized chunk blocks:
+//   u8 flags, CHUNK_CODEC_LZ set when the body below went through lz.c,
+//   then a u32 body size in that case
+//   body: u8 palette size - 1, the palette's block types,
+//         runs of (varint length - 1, u8 palette index) over the blocks,
+//         runs of (varint length - 1, u8 byte) over the light, two z neighbors per byte
+//   blocks are visited one y layer at a time, then x, then z
+#define CHUNK_CODEC_LZ 0x01
+#define CHUNK_CODEC_LIGHT_SIZE (MAX_CHUNK_SIZE / 2)
+#define CHUNK_CODEC_BODY_MAX (1 + 256 + MAX_CHUNK_SIZE * 2 + CHUNK_CODEC_LIGHT_SIZE * 2)
+#define CHUNK_CODEC_MAX_SIZE (5 + LZ_BOUND(CHUNK_CODEC_BODY_MAX))
+
+// lz is tried when compress is set and kept only if it is smaller, returns 0 on failure
+size_t chunk_codec_encode(const Block* blocks, uint8_t* out, size_t capacity, bool compress);
+bool chunk_codec_decode(const uint8_t* data, size_t size, Block* blocks);
+
+#endif // CHUNK_CODEC_H
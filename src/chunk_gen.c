@@ -0,0 +1,125 @@
+#include "chunk_gen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void chunk_gen_add_light(ChunkGenTask* task, LightNode node) {
+    if (task->light_count == task->light_capacity) {
+        int capacity = task->light_capacity ? task->light_capacity * 2 : 16;
+        LightNode* lights = realloc(task->lights, capacity * sizeof(LightNode));
+        if (!lights) {
+            fprintf(stderr, "CHUNK_GEN: failed to grow light list\n");
+            return;
+        }
+        task->lights = lights;
+        task->light_capacity = capacity;
+    }
+    task->lights[task->light_count++] = node;
+}
+
+// emitters start at full level, propagation runs on the main thread once published
+void chunk_gen_seed_light(Block* blocks, int cx, int cy, int cz, ChunkGenLightCallback emit, void* user) {
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int z = 0; z < CHUNK_SIZE; z++) {
+                Block* block = &blocks[chunk_get_block_index(x, y, z)];
+                uint8_t emission = block_get_emission(block->type);
+                if (emission == 0) continue;
+
+                block->light_level = emission;
+                emit(user, (LightNode){
+                    cx * CHUNK_SIZE + x,
+                    cy * CHUNK_SIZE + y,
+                    cz * CHUNK_SIZE + z,
+                    emission
+                });
+            }
+        }
+    }
+}
+
+static void chunk_gen_emit(void* user, LightNode node) {
+    chunk_gen_add_light(user, node);
+}
+
+static void chunk_gen_run(void* arg) {
+    ChunkGenTask* task = arg;
+    ChunkGenerator* generator = task->generator;
+
+    task->blocks = malloc(MAX_CHUNK_SIZE * sizeof(Block));
+    if (task->blocks) {
+        terrain_fill(generator->terrain, task->blocks, task->cx, task->cy, task->cz);
+        terrain_carve_caves(generator->terrain, task->blocks, task->cx, task->cy, task->cz);
+        terrain_decorate(generator->terrain, task->blocks, task->cx, task->cy, task->cz);
+        chunk_gen_seed_light(task->blocks, task->cx, task->cy, task->cz, chunk_gen_emit, task);
+    } else {
+        fprintf(stderr, "CHUNK_GEN: failed to allocate blocks\n");
+    }
+
+    mutex_lock(&generator->mutex);
+    task->next = generator->completed;
+    generator->completed = task;
+    mutex_unlock(&generator->mutex);
+}
+
+void chunk_gen_init(ChunkGenerator* generator, TerrainGenerator* terrain) {
+    memset(generator, 0, sizeof(*generator));
+    generator->terrain = terrain;
+    mutex_init(&generator->mutex);
+    if (!thread_pool_init(&generator->pool, 0)) {
+        fprintf(stderr, "CHUNK_GEN: no worker threads, generating on the main thread\n");
+    }
+}
+
+void chunk_gen_free(ChunkGenerator* generator) {
+    thread_pool_free(&generator->pool);
+
+    ChunkGenTask* task = chunk_gen_take_completed(generator);
+    while (task) {
+        ChunkGenTask* next = task->next;
+        chunk_gen_task_free(task);
+        task = next;
+    }
+    mutex_destroy(&generator->mutex);
+}
+
+void chunk_gen_request(ChunkGenerator* generator, int chunk_index, int cx, int cy, int cz) {
+    ChunkGenTask* task = calloc(1, sizeof(ChunkGenTask));
+    if (!task) {
+        fprintf(stderr, "CHUNK_GEN: failed to allocate task\n");
+        return;
+    }
+    task->generator = generator;
+    task->chunk_index = chunk_index;
+    task->cx = cx;
+    task->cy = cy;
+    task->cz = cz;
+
+    mutex_lock(&generator->mutex);
+    generator->in_flight++;
+    mutex_unlock(&generator->mutex);
+
+    thread_pool_submit(&generator->pool, chunk_gen_run, task);
+}
+
+void chunk_gen_wait(ChunkGenerator* generator) {
+    thread_pool_wait(&generator->pool);
+}
+
+ChunkGenTask* chunk_gen_take_completed(ChunkGenerator* generator) {
+    mutex_lock(&generator->mutex);
+    ChunkGenTask* completed = generator->completed;
+    generator->completed = NULL;
+    for (ChunkGenTask* task = completed; task; task = task->next) {
+        generator->in_flight--;
+    }
+    mutex_unlock(&generator->mutex);
+    return completed;
+}
+
+void chunk_gen_task_free(ChunkGenTask* task) {
+    free(task->blocks);
+    free(task->lights);
+    free(task);
+}
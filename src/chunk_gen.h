@@ -0,0 +1,50 @@
+#ifndef CHUNK_GEN_H
+#define CHUNK_GEN_H
+
+#include <stdbool.h>
+
+#include "block.h"
+#include "light_queue.h"
+#include "terrain.h"
+#include "thread_pool.h"
+
+// one chunk generated on a worker: terrain, caves, decoration, then the
+// initial light; nothing outside the task is written until it is published
+typedef struct ChunkGenTask {
+    struct ChunkGenerator* generator;
+    int chunk_index;
+    int cx, cy, cz;
+
+    Block* blocks;       // MAX_CHUNK_SIZE blocks owned by the task until published
+    LightNode* lights;   // emitters found by the light stage, world coordinates
+    int light_count;
+    int light_capacity;
+
+    struct ChunkGenTask* next;
+} ChunkGenTask;
+
+typedef struct ChunkGenerator {
+    ThreadPool pool;
+    TerrainGenerator* terrain;
+
+    Mutex mutex;
+    ChunkGenTask* completed; // finished tasks waiting for the main thread
+    int in_flight;
+} ChunkGenerator;
+
+void chunk_gen_init(ChunkGenerator* generator, TerrainGenerator* terrain);
+void chunk_gen_free(ChunkGenerator* generator); // waits for running tasks
+
+void chunk_gen_request(ChunkGenerator* generator, int chunk_index, int cx, int cy, int cz);
+void chunk_gen_wait(ChunkGenerator* generator);
+
+// hands over every finished task, the caller publishes and frees them
+ChunkGenTask* chunk_gen_take_completed(ChunkGenerator* generator);
+void chunk_gen_task_free(ChunkGenTask* task);
+
+// sets every emitter in the chunk to its full level and hands it to emit,
+// the generator's light stage and chunks read back from disk share it
+typedef void (*ChunkGenLightCallback)(void* user, LightNode node);
+void chunk_gen_seed_light(Block* blocks, int cx, int cy, int cz, ChunkGenLightCallback emit, void* user);
+
+#endif // CHUNK_GEN_H
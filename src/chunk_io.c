@@ -0,0 +1,351 @@
+#include "chunk_io.h"
+#include "chunk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void request_free(ChunkIORequest* request) {
+    free(request->blocks);
+    free(request);
+}
+
+static void request_free_list(ChunkIORequest* request) {
+    while (request) {
+        ChunkIORequest* next = request->next;
+        request_free(request);
+        request = next;
+    }
+}
+
+static float chunk_io_distance(const ChunkIO* io, const ChunkIORequest* request) {
+    float dx = (request->cx + 0.5f) * CHUNK_SIZE - io->focus[0];
+    float dy = (request->cy + 0.5f) * CHUNK_SIZE - io->focus[1];
+    float dz = (request->cz + 0.5f) * CHUNK_SIZE - io->focus[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// squared distances, equal ones fall back to the chunk index so the order
+// does not depend on how the queue was filled
+static bool chunk_io_nearer(float distance, const ChunkIORequest* request, float other_distance, const ChunkIORequest* other) {
+    if (distance != other_distance) return distance < other_distance;
+    return request->chunk_index < other->chunk_index;
+}
+
+// unlinks the load nearest to the focus, and names the one after it so its
+// pages can be prefetched while this one decodes
+static ChunkIORequest* chunk_io_take_nearest(ChunkIO* io, int* next_cx, int* next_cy, int* next_cz, bool* has_next) {
+    ChunkIORequest** best = NULL;
+    const ChunkIORequest* second = NULL;
+    float best_distance = 0.0f, second_distance = 0.0f;
+
+    for (ChunkIORequest** link = &io->loads; *link; link = &(*link)->next) {
+        float distance = chunk_io_distance(io, *link);
+        if (!best || chunk_io_nearer(distance, *link, best_distance, *best)) {
+            if (best) {
+                second = *best;
+                second_distance = best_distance;
+            }
+            best = link;
+            best_distance = distance;
+        } else if (!second || chunk_io_nearer(distance, *link, second_distance, second)) {
+            second = *link;
+            second_distance = distance;
+        }
+    }
+
+    *has_next = second != NULL;
+    if (second) {
+        *next_cx = second->cx;
+        *next_cy = second->cy;
+        *next_cz = second->cz;
+    }
+
+    ChunkIORequest* request = *best;
+    *best = request->next;
+    request->next = NULL;
+    return request;
+}
+
+// called with the mutex held; a save still queued for the chunk is newer
+// than what the region file has, the load gets a copy of its snapshot
+static bool chunk_io_load_from_saves(ChunkIO* io, ChunkIORequest* request) {
+    for (const ChunkIORequest* save = io->saves; save; save = save->next) {
+        if (save->cx != request->cx || save->cy != request->cy || save->cz != request->cz) continue;
+
+        request->blocks = malloc(MAX_CHUNK_SIZE * sizeof(Block));
+        if (!request->blocks) return false;
+        memcpy(request->blocks, save->blocks, MAX_CHUNK_SIZE * sizeof(Block));
+        request->success = true;
+        return true;
+    }
+    return false;
+}
+
+static void chunk_io_run_load(ChunkIO* io, ChunkIORequest* request) {
+    request->blocks = malloc(MAX_CHUNK_SIZE * sizeof(Block));
+    request->success = request->blocks &&
+        region_store_read_chunk(io->store, request->cx, request->cy, request->cz, request->blocks);
+    if (!request->success) {
+        free(request->blocks);
+        request->blocks = NULL;
+    }
+}
+
+static void chunk_io_run_save(ChunkIO* io, ChunkIORequest* request) {
+    request->success = region_store_write_chunk(io->store, request->cx, request->cy, request->cz, request->blocks);
+    free(request->blocks); // the snapshot is not needed past this point
+    request->blocks = NULL;
+}
+
+static bool chunk_io_same_region(const ChunkIORequest* a, const ChunkIORequest* b) {
+    return region_floor_div(a->cx) == region_floor_div(b->cx) && region_floor_div(a->cz) == region_floor_div(b->cz);
+}
+
+// a sorted batch, every chunk of a region file is staged before the file is
+// synced once and its table updated
+static void chunk_io_run_saves(ChunkIO* io, ChunkIORequest** batch, int count) {
+    int group = 0;
+    for (int i = 0; i < count; i++) {
+        ChunkIORequest* request = batch[i];
+        request->success = region_store_stage_chunk(io->store, request->cx, request->cy, request->cz, request->blocks);
+        free(request->blocks);
+        request->blocks = NULL;
+
+        if (i + 1 < count && chunk_io_same_region(request, batch[i + 1])) continue;
+        bool committed = region_store_commit(io->store);
+        for (; group <= i; group++) {
+            batch[group]->success = batch[group]->success && committed;
+        }
+    }
+}
+
+// region files in turn, slots in order within each
+static int chunk_io_compare_saves(const void* a, const void* b) {
+    const ChunkIORequest* ra = *(const ChunkIORequest* const*)a;
+    const ChunkIORequest* rb = *(const ChunkIORequest* const*)b;
+    int keys_a[5] = { region_floor_div(ra->cx), region_floor_div(ra->cz), ra->cx, ra->cz, ra->cy };
+    int keys_b[5] = { region_floor_div(rb->cx), region_floor_div(rb->cz), rb->cx, rb->cz, rb->cy };
+    for (int i = 0; i < 5; i++) {
+        if (keys_a[i] != keys_b[i]) return keys_a[i] < keys_b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// called with the mutex held
+static void chunk_io_complete(ChunkIO* io, ChunkIORequest* request) {
+    request->next = NULL;
+    if (io->completed_tail) io->completed_tail->next = request;
+    else io->completed = request;
+    io->completed_tail = request;
+}
+
+static void chunk_io_worker(void* arg) {
+    ChunkIO* io = arg;
+
+    mutex_lock(&io->mutex);
+    while (true) {
+        while (io->running && !io->loads && !io->saves) {
+            cond_wait(&io->cond, &io->mutex);
+        }
+        // stopping still writes what was queued, loads are dropped
+        if (!io->running && !io->saves) break;
+
+        if (io->running && io->loads) {
+            int next_cx = 0, next_cy = 0, next_cz = 0;
+            bool has_next;
+            ChunkIORequest* request = chunk_io_take_nearest(io, &next_cx, &next_cy, &next_cz, &has_next);
+            bool from_save = chunk_io_load_from_saves(io, request);
+            io->in_flight++;
+            mutex_unlock(&io->mutex);
+
+            if (has_next) region_store_prefetch_chunk(io->store, next_cx, next_cy, next_cz);
+            if (!from_save) chunk_io_run_load(io, request);
+
+            mutex_lock(&io->mutex);
+            chunk_io_complete(io, request);
+            io->in_flight--;
+        } else {
+            // a batch of saves, sorted so each region file is written front to back
+            ChunkIORequest* batch[CHUNK_IO_SAVE_BATCH];
+            int count = 0;
+            while (io->saves && count < CHUNK_IO_SAVE_BATCH) {
+                batch[count++] = io->saves;
+                io->saves = io->saves->next;
+            }
+            io->in_flight += count;
+            io->saving = count;
+            mutex_unlock(&io->mutex);
+
+            qsort(batch, count, sizeof(batch[0]), chunk_io_compare_saves);
+            chunk_io_run_saves(io, batch, count);
+
+            mutex_lock(&io->mutex);
+            for (int i = 0; i < count; i++) {
+                chunk_io_complete(io, batch[i]);
+            }
+            io->in_flight -= count;
+            io->saving = 0;
+        }
+
+        if (!io->loads && !io->saves && !io->in_flight) cond_broadcast(&io->idle_cond);
+    }
+    cond_broadcast(&io->idle_cond);
+    mutex_unlock(&io->mutex);
+}
+
+void chunk_io_init(ChunkIO* io, RegionStore* store, ChunkIOCallback callback, void* user) {
+    memset(io, 0, sizeof(*io));
+    io->store = store;
+    io->callback = callback;
+    io->user = user;
+    mutex_init(&io->mutex);
+    cond_init(&io->cond);
+    cond_init(&io->idle_cond);
+    io->running = true;
+
+    io->started = thread_create(&io->thread, chunk_io_worker, io);
+    if (!io->started) {
+        fprintf(stderr, "CHUNK_IO: no io thread, disk access runs on the caller\n");
+    }
+}
+
+void chunk_io_free(ChunkIO* io) {
+    mutex_lock(&io->mutex);
+    io->running = false;
+    cond_signal(&io->cond);
+    mutex_unlock(&io->mutex);
+    if (io->started) thread_join(&io->thread);
+
+    request_free_list(io->loads);
+    request_free_list(io->saves);
+    request_free_list(io->completed);
+
+    cond_destroy(&io->idle_cond);
+    cond_destroy(&io->cond);
+    mutex_destroy(&io->mutex);
+    memset(io, 0, sizeof(*io));
+}
+
+void chunk_io_set_focus(ChunkIO* io, const float position[3]) {
+    mutex_lock(&io->mutex);
+    io->focus[0] = position[0];
+    io->focus[1] = position[1];
+    io->focus[2] = position[2];
+    mutex_unlock(&io->mutex);
+}
+
+void chunk_io_load(ChunkIO* io, int chunk_index, int cx, int cy, int cz) {
+    ChunkIORequest* request = calloc(1, sizeof(ChunkIORequest));
+    if (!request) {
+        fprintf(stderr, "CHUNK_IO: failed to allocate load request\n");
+        return;
+    }
+    request->type = CHUNK_IO_LOAD;
+    request->chunk_index = chunk_index;
+    request->cx = cx;
+    request->cy = cy;
+    request->cz = cz;
+
+    if (!io->started) {
+        chunk_io_run_load(io, request);
+        mutex_lock(&io->mutex);
+        chunk_io_complete(io, request);
+        mutex_unlock(&io->mutex);
+        return;
+    }
+
+    mutex_lock(&io->mutex);
+    request->next = io->loads;
+    io->loads = request;
+    cond_signal(&io->cond);
+    mutex_unlock(&io->mutex);
+}
+
+void chunk_io_save(ChunkIO* io, int chunk_index, int cx, int cy, int cz, const Block* blocks, uint32_t generation) {
+    // the copy happens outside the lock, the io thread never waits on it
+    Block* snapshot = malloc(MAX_CHUNK_SIZE * sizeof(Block));
+    if (!snapshot) {
+        fprintf(stderr, "CHUNK_IO: failed to allocate save snapshot\n");
+        return;
+    }
+    memcpy(snapshot, blocks, MAX_CHUNK_SIZE * sizeof(Block));
+
+    mutex_lock(&io->mutex);
+    for (ChunkIORequest* queued = io->saves; queued; queued = queued->next) {
+        if (queued->cx != cx || queued->cy != cy || queued->cz != cz) continue;
+
+        // still waiting, the newer snapshot replaces it
+        Block* old = queued->blocks;
+        queued->blocks = snapshot;
+        queued->generation = generation;
+        mutex_unlock(&io->mutex);
+        free(old);
+        return;
+    }
+    mutex_unlock(&io->mutex);
+
+    ChunkIORequest* request = calloc(1, sizeof(ChunkIORequest));
+    if (!request) {
+        fprintf(stderr, "CHUNK_IO: failed to allocate save request\n");
+        free(snapshot);
+        return;
+    }
+    request->type = CHUNK_IO_SAVE;
+    request->chunk_index = chunk_index;
+    request->cx = cx;
+    request->cy = cy;
+    request->cz = cz;
+    request->blocks = snapshot;
+    request->generation = generation;
+
+    if (!io->started) {
+        chunk_io_run_save(io, request);
+        mutex_lock(&io->mutex);
+        chunk_io_complete(io, request);
+        mutex_unlock(&io->mutex);
+        return;
+    }
+
+    mutex_lock(&io->mutex);
+    request->next = io->saves;
+    io->saves = request;
+    cond_signal(&io->cond);
+    mutex_unlock(&io->mutex);
+}
+
+void chunk_io_wait(ChunkIO* io) {
+    if (!io->started) return;
+    mutex_lock(&io->mutex);
+    while (io->running && (io->loads || io->saves || io->in_flight)) {
+        cond_wait(&io->idle_cond, &io->mutex);
+    }
+    mutex_unlock(&io->mutex);
+}
+
+int chunk_io_poll(ChunkIO* io) {
+    mutex_lock(&io->mutex);
+    ChunkIORequest* request = io->completed;
+    io->completed = io->completed_tail = NULL;
+    mutex_unlock(&io->mutex);
+
+    int count = 0;
+    while (request) {
+        ChunkIORequest* next = request->next;
+        if (io->callback) io->callback(io->user, request);
+        request_free(request);
+        request = next;
+        count++;
+    }
+    return count;
+}
+
+int chunk_io_pending_saves(ChunkIO* io) {
+    mutex_lock(&io->mutex);
+    int count = io->saving;
+    for (ChunkIORequest* request = io->saves; request; request = request->next) {
+        count++;
+    }
+    mutex_unlock(&io->mutex);
+    return count;
+}
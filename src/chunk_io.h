@@ -0,0 +1,65 @@
+#ifndef CHUNK_IO_H
+#define CHUNK_IO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block.h"
+#include "region.h"
+#include "thread.h"
+
+#define CHUNK_IO_SAVE_BATCH 64 // saves written per pass before pending loads get another turn
+
+typedef enum {
+    CHUNK_IO_LOAD,
+    CHUNK_IO_SAVE
+} ChunkIOType;
+
+typedef struct ChunkIORequest {
+    ChunkIOType type;
+    int chunk_index;
+    int cx, cy, cz;
+    Block* blocks;       // loads: read by the io thread, saves: snapshot taken when queued
+    bool success;        // loads: found in a region file, saves: written
+    uint32_t generation; // caller's tag, handed back unchanged
+    struct ChunkIORequest* next;
+} ChunkIORequest;
+
+// runs on the thread calling chunk_io_poll, may take request->blocks and set it to NULL
+typedef void (*ChunkIOCallback)(void* user, ChunkIORequest* request);
+
+// one thread owns the region store and does all disk work; loads go nearest
+// to the focus first, saves of the same chunk collapse into the newest one
+typedef struct {
+    Thread thread;
+    Mutex mutex;
+    CondVar cond;      // signaled when work is queued or the thread stops
+    CondVar idle_cond; // signaled when both queues are empty and nothing is in flight
+    bool running;
+    bool started;
+
+    RegionStore* store;
+    ChunkIOCallback callback;
+    void* user;
+
+    ChunkIORequest* loads;
+    ChunkIORequest* saves;
+    int in_flight; // taken from a queue, not completed yet
+    int saving;    // saves in the batch being written
+    ChunkIORequest* completed;
+    ChunkIORequest* completed_tail;
+    float focus[3]; // world position loads are ordered by
+} ChunkIO;
+
+void chunk_io_init(ChunkIO* io, RegionStore* store, ChunkIOCallback callback, void* user);
+void chunk_io_free(ChunkIO* io); // writes every queued save, drops pending loads and completions
+
+void chunk_io_set_focus(ChunkIO* io, const float position[3]);
+void chunk_io_load(ChunkIO* io, int chunk_index, int cx, int cy, int cz);
+void chunk_io_save(ChunkIO* io, int chunk_index, int cx, int cy, int cz, const Block* blocks, uint32_t generation); // copies blocks
+
+void chunk_io_wait(ChunkIO* io); // until the queues drain, for loading screens and shutdown
+int chunk_io_poll(ChunkIO* io);  // hands finished requests to the callback, returns how many
+int chunk_io_pending_saves(ChunkIO* io); // queued or being written
+
+#endif // CHUNK_IO_H
@@ -0,0 +1,181 @@
+#include "chunk_tree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ALL_PLANES 0x3F
+
+static int tree_alloc(ChunkTree* tree, int count) {
+    if (tree->node_count + count > tree->node_capacity) {
+        int capacity = tree->node_capacity ? tree->node_capacity * 2 : 64;
+        while (capacity < tree->node_count + count) capacity *= 2;
+
+        tree->nodes = realloc(tree->nodes, capacity * sizeof(ChunkTreeNode));
+        tree->node_capacity = capacity;
+    }
+
+    int first = tree->node_count;
+    tree->node_count += count;
+    return first;
+}
+
+// fills node with the chunks in [lo, hi], splitting every axis that is wider than one chunk
+static void tree_build(ChunkTree* tree, const ChunkBounds* bounds, int (*get_index)(int, int, int),
+        int node, int parent, const int lo[3], const int hi[3]) {
+    tree->nodes[node].parent = parent;
+    tree->nodes[node].first_child = -1;
+    tree->nodes[node].child_count = 0;
+    tree->nodes[node].chunk_index = -1;
+    tree->nodes[node].index_count = 0;
+
+    if (lo[0] == hi[0] && lo[1] == hi[1] && lo[2] == hi[2]) {
+        int chunk = get_index(lo[0], lo[1], lo[2]);
+
+        ChunkTreeNode* leaf = &tree->nodes[node];
+        leaf->chunk_index = chunk;
+        leaf->min[0] = bounds->min_x[chunk];
+        leaf->min[1] = bounds->min_y[chunk];
+        leaf->min[2] = bounds->min_z[chunk];
+        leaf->max[0] = bounds->max_x[chunk];
+        leaf->max[1] = bounds->max_y[chunk];
+        leaf->max[2] = bounds->max_z[chunk];
+        tree->chunk_leaf[chunk] = node;
+        return;
+    }
+
+    int splits[3][2][2]; // axis, half, lo/hi
+    int split_count[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        if (lo[axis] == hi[axis]) {
+            splits[axis][0][0] = lo[axis];
+            splits[axis][0][1] = hi[axis];
+            split_count[axis] = 1;
+        } else {
+            int mid = lo[axis] + (hi[axis] - lo[axis]) / 2;
+            splits[axis][0][0] = lo[axis];
+            splits[axis][0][1] = mid;
+            splits[axis][1][0] = mid + 1;
+            splits[axis][1][1] = hi[axis];
+            split_count[axis] = 2;
+        }
+    }
+
+    int child_count = split_count[0] * split_count[1] * split_count[2];
+    int first = tree_alloc(tree, child_count);
+    tree->nodes[node].first_child = first;
+    tree->nodes[node].child_count = child_count;
+
+    int child = first;
+    for (int sx = 0; sx < split_count[0]; ++sx) {
+        for (int sy = 0; sy < split_count[1]; ++sy) {
+            for (int sz = 0; sz < split_count[2]; ++sz) {
+                int child_lo[3] = { splits[0][sx][0], splits[1][sy][0], splits[2][sz][0] };
+                int child_hi[3] = { splits[0][sx][1], splits[1][sy][1], splits[2][sz][1] };
+                tree_build(tree, bounds, get_index, child++, node, child_lo, child_hi);
+            }
+        }
+    }
+
+    // nodes may have moved while building the children
+    ChunkTreeNode* n = &tree->nodes[node];
+    glm_vec3_copy(tree->nodes[first].min, n->min);
+    glm_vec3_copy(tree->nodes[first].max, n->max);
+    for (int c = first + 1; c < first + child_count; ++c) {
+        for (int axis = 0; axis < 3; ++axis) {
+            n->min[axis] = fminf(n->min[axis], tree->nodes[c].min[axis]);
+            n->max[axis] = fmaxf(n->max[axis], tree->nodes[c].max[axis]);
+        }
+    }
+}
+
+void chunk_tree_init(ChunkTree* tree, const ChunkBounds* bounds, int size_x, int size_y, int size_z,
+        int (*get_index)(int x, int y, int z)) {
+    memset(tree, 0, sizeof(*tree));
+
+    tree->chunk_leaf = malloc(bounds->count * sizeof(int));
+
+    int lo[3] = { 0, 0, 0 };
+    int hi[3] = { size_x - 1, size_y - 1, size_z - 1 };
+    int root = tree_alloc(tree, 1);
+    tree_build(tree, bounds, get_index, root, -1, lo, hi);
+
+    tree->stack = malloc(tree->node_count * sizeof(int));
+    tree->stack_mask = malloc(tree->node_count * sizeof(int));
+    tree->candidates = malloc(bounds->count * sizeof(int));
+    chunk_bounds_init(&tree->candidate_bounds, bounds->count);
+    tree->candidate_mask = calloc((bounds->count + 31) / 32, sizeof(uint32_t));
+}
+
+void chunk_tree_free(ChunkTree* tree) {
+    free(tree->nodes);
+    free(tree->chunk_leaf);
+    free(tree->stack);
+    free(tree->stack_mask);
+    free(tree->candidates);
+    chunk_bounds_free(&tree->candidate_bounds);
+    free(tree->candidate_mask);
+    memset(tree, 0, sizeof(*tree));
+}
+
+void chunk_tree_set_geometry(ChunkTree* tree, int chunk_index, size_t index_count) {
+    int node = tree->chunk_leaf[chunk_index];
+    size_t old_count = tree->nodes[node].index_count;
+    if (old_count == index_count) return;
+
+    for (; node != -1; node = tree->nodes[node].parent) {
+        tree->nodes[node].index_count = tree->nodes[node].index_count - old_count + index_count;
+    }
+}
+
+int chunk_tree_cull(ChunkTree* tree, const Frustum* frustum, int* out_indices) {
+    int visible = 0;
+    int candidate_count = 0;
+    int top = 0;
+
+    if (tree->node_count == 0 || tree->nodes[0].index_count == 0) return 0;
+
+    tree->stack[top] = 0;
+    tree->stack_mask[top] = ALL_PLANES;
+    top++;
+
+    while (top > 0) {
+        top--;
+        const ChunkTreeNode* node = &tree->nodes[tree->stack[top]];
+        int mask = tree->stack_mask[top];
+
+        if (node->index_count == 0) continue; // nothing to draw below
+
+        if (node->chunk_index != -1) {
+            if (mask == 0) {
+                out_indices[visible++] = node->chunk_index;
+            } else {
+                // leaves straddling a plane are left to the batch test below
+                tree->candidates[candidate_count] = node->chunk_index;
+                chunk_bounds_set(&tree->candidate_bounds, candidate_count, node->min, node->max);
+                candidate_count++;
+            }
+            continue;
+        }
+
+        if (mask && frustum_classify_aabb(frustum, node->min, node->max, &mask) == FRUSTUM_OUTSIDE) continue;
+
+        for (int c = 0; c < node->child_count; ++c) {
+            tree->stack[top] = node->first_child + c;
+            tree->stack_mask[top] = mask;
+            top++;
+        }
+    }
+
+    if (candidate_count > 0) {
+        tree->candidate_bounds.count = candidate_count;
+        frustum_cull_bounds(frustum, &tree->candidate_bounds, tree->candidate_mask);
+
+        for (int i = 0; i < candidate_count; ++i) {
+            if (tree->candidate_mask[i / 32] & (1u << (i % 32))) {
+                out_indices[visible++] = tree->candidates[i];
+            }
+        }
+    }
+
+    return visible;
+}
@@ -0,0 +1,41 @@
+#ifndef CHUNK_TREE_H
+#define CHUNK_TREE_H
+
+#include <cglm/cglm.h>
+#include <stddef.h>
+
+#include "frustum.h"
+
+// octree over the loaded chunk grid, lets culling reject whole regions at once
+typedef struct {
+    vec3 min;
+    vec3 max;
+    int parent;         // -1 for the root
+    int first_child;    // children are stored contiguously, -1 for leaves
+    int child_count;
+    int chunk_index;    // leaves only, -1 otherwise
+    size_t index_count; // geometry of every chunk below this node
+} ChunkTreeNode;
+
+typedef struct {
+    ChunkTreeNode* nodes;
+    int node_count;
+    int node_capacity;
+    int* chunk_leaf; // chunk index -> leaf node
+
+    // per frame scratch
+    int* stack;
+    int* stack_mask;
+    int* candidates;
+    ChunkBounds candidate_bounds;
+    uint32_t* candidate_mask;
+} ChunkTree;
+
+// get_index maps chunk grid coordinates to the indices used by bounds
+void chunk_tree_init(ChunkTree* tree, const ChunkBounds* bounds, int size_x, int size_y, int size_z,
+    int (*get_index)(int x, int y, int z));
+void chunk_tree_free(ChunkTree* tree);
+void chunk_tree_set_geometry(ChunkTree* tree, int chunk_index, size_t index_count);
+int chunk_tree_cull(ChunkTree* tree, const Frustum* frustum, int* out_indices); // returns visible count
+
+#endif // CHUNK_TREE_H
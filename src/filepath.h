@@ -4,11 +4,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 
 #ifdef __linux
 #include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
 
-char* get_self_directory(void) {
+static inline char* get_self_directory(void) {
     char exe_path[1024];
     ssize_t path_length = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
     if (path_length == -1)
@@ -25,8 +28,11 @@ char* get_self_directory(void) {
 
 #elif defined _WIN32
 #include <Windows.h>
+#include <direct.h>
+#include <errno.h>
+#include <sys/stat.h>
 
-char* get_self_directory(void) {
+static inline char* get_self_directory(void) {
     char exe_path[1024];
     DWORD path_length = GetModuleFileNameA(NULL, exe_path, sizeof(exe_path) - 1);
     if (path_length == 0) return NULL;
@@ -48,7 +54,7 @@ char* get_self_directory(void) {
 #error get_self_directory not implemented for the current platform
 #endif
 
-char* get_parent_directory(const char* path) {
+static inline char* get_parent_directory(const char* path) {
     if (!path) {
         fprintf(stderr, "FILEPATH ERROR: could not determine parent directory\n");
         return NULL;
@@ -71,7 +77,7 @@ char* get_parent_directory(const char* path) {
     return strdup(temp);
 }
 
-int path_make_absolute(char* out_path, const char* relative_path) {
+static inline int path_make_absolute(char* out_path, const char* relative_path) {
 	if (!out_path || !relative_path) {
         fprintf(stderr, "FILEPATH ERROR: relative_path or out_path is NULL\n");
         return -1;
@@ -102,11 +108,41 @@ int path_make_absolute(char* out_path, const char* relative_path) {
 	return 0;
 }
 
-char* make_path(char* path) {
+static inline char* make_path(char* path) {
     char* absolute = malloc(1024);
     if (!absolute) return NULL;
     path_make_absolute(absolute, path);
     return absolute;
 }
 
+// creates every missing directory along path, returns 0 if it exists afterwards
+static inline int path_make_directory(const char* path) {
+    char temp[1024];
+    strncpy(temp, path, sizeof(temp) - 1);
+    temp[sizeof(temp) - 1] = '\0';
+
+    size_t length = strlen(temp);
+    for (size_t i = 1; i <= length; i++) {
+        if (temp[i] != '/' && temp[i] != '\\' && temp[i] != '\0') continue;
+
+        char separator = temp[i];
+        temp[i] = '\0';
+#if defined(_WIN32)
+        int result = _mkdir(temp);
+#else
+        int result = mkdir(temp, 0755);
+#endif
+        // drive roots and the like refuse mkdir but already exist
+        struct stat info;
+        bool exists = result == 0 || errno == EEXIST || stat(temp, &info) == 0;
+        temp[i] = separator;
+
+        if (!exists) {
+            fprintf(stderr, "FILEPATH ERROR: could not create directory %s\n", path);
+            return -1;
+        }
+    }
+    return 0;
+}
+
 #endif // FILEPATH_H
@@ -5,6 +5,19 @@
 #include <cglm/cglm.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_BATCH_WIDTH 8
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_BATCH_SSE
+#define FRUSTUM_BATCH_WIDTH 4
+#else
+#define FRUSTUM_BATCH_WIDTH 1
+#endif
 
 #include "camera.h"
 #include "chunk.h"
@@ -23,98 +36,32 @@ typedef struct {
     Plane far_face;
 } Frustum;
 
-static inline Frustum create_frustum_from_camera(
-    const Camera* cam,
-    float aspect,
-    float fov_y,
-    float z_near,
-    float z_far
-) {
+// Gribb/Hartmann plane extraction, cglm matrices are column major
+static inline Frustum create_frustum_from_matrix(const mat4 view_projection) {
     Frustum frustum;
+    Plane* planes[6] = {
+        &frustum.left_face,
+        &frustum.right_face,
+        &frustum.bottom_face,
+        &frustum.top_face,
+        &frustum.near_face,
+        &frustum.far_face
+    };
 
-    vec3 forward, up, right;
-    glm_vec3_copy((float*)cam->front, forward); glm_vec3_normalize(forward);
-    glm_vec3_copy((float*)cam->up, up);         glm_vec3_normalize(up);
-    glm_vec3_copy((float*)cam->right, right);   glm_vec3_normalize(right);
-
-    vec3 cam_pos;
-    glm_vec3_copy((float*)cam->position, cam_pos);
-
-    vec3 near_center, far_center;
-    glm_vec3_scale(forward, z_near, near_center);
-    glm_vec3_add(cam_pos, near_center, near_center);
-
-    glm_vec3_scale(forward, z_far, far_center);
-    glm_vec3_add(cam_pos, far_center, far_center);
-
-    float tan_fov = tanf(fov_y * 0.5f);
-    float near_height = z_near * tan_fov;
-    float near_width  = near_height * aspect;
-    float far_height  = z_far * tan_fov;
-    float far_width   = far_height * aspect;
-
-    // near plane
-    glm_vec3_copy(forward, frustum.near_face.normal);
-    glm_vec3_normalize(frustum.near_face.normal);
-    frustum.near_face.distance = glm_vec3_dot(frustum.near_face.normal, near_center);
-
-    // far plane
-    vec3 neg_forward;
-    glm_vec3_negate_to(forward, neg_forward);
-    glm_vec3_copy(neg_forward, frustum.far_face.normal);
-    glm_vec3_normalize(frustum.far_face.normal);
-    frustum.far_face.distance = glm_vec3_dot(frustum.far_face.normal, far_center);
-
-    // right plane
-    {
-        vec3 far_right, point;
-        glm_vec3_scale(right, far_width, far_right);
-        glm_vec3_sub(far_center, far_right, point);
-
-        vec3 dir;
-        glm_vec3_sub(point, cam_pos, dir);
-        glm_vec3_cross(dir, up, frustum.right_face.normal);
-        glm_vec3_normalize(frustum.right_face.normal);
-        frustum.right_face.distance = glm_vec3_dot(frustum.right_face.normal, point);
-    }
-
-    // left plane
-    {
-        vec3 far_left, point;
-        glm_vec3_scale(right, far_width, far_left);
-        glm_vec3_add(far_center, far_left, point);
-
-        vec3 dir;
-        glm_vec3_sub(point, cam_pos, dir);
-        glm_vec3_cross(up, dir, frustum.left_face.normal);
-        glm_vec3_normalize(frustum.left_face.normal);
-        frustum.left_face.distance = glm_vec3_dot(frustum.left_face.normal, point);
-    }
+    for (int i = 0; i < 6; ++i) {
+        int row = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
 
-    // top plane
-    {
-        vec3 far_top, point;
-        glm_vec3_scale(up, far_height, far_top);
-        glm_vec3_sub(far_center, far_top, point);
-
-        vec3 dir;
-        glm_vec3_sub(point, cam_pos, dir);
-        glm_vec3_cross(right, dir, frustum.top_face.normal);
-        glm_vec3_normalize(frustum.top_face.normal);
-        frustum.top_face.distance = glm_vec3_dot(frustum.top_face.normal, point);
-    }
+        vec4 plane;
+        for (int col = 0; col < 4; ++col) {
+            plane[col] = view_projection[col][3] + sign * view_projection[col][row];
+        }
 
-	// bottom plane
-    {
-        vec3 far_bottom, point;
-        glm_vec3_scale(up, far_height, far_bottom);
-        glm_vec3_add(far_center, far_bottom, point);
-
-        vec3 dir;
-        glm_vec3_sub(point, cam_pos, dir);
-        glm_vec3_cross(dir, right, frustum.bottom_face.normal);
-        glm_vec3_normalize(frustum.bottom_face.normal);
-        frustum.bottom_face.distance = glm_vec3_dot(frustum.bottom_face.normal, point);
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        planes[i]->normal[0] = plane[0] / length;
+        planes[i]->normal[1] = plane[1] / length;
+        planes[i]->normal[2] = plane[2] / length;
+        planes[i]->distance = -plane[3] / length;
     }
 
     return frustum;
@@ -159,4 +106,145 @@ static inline bool chunk_in_frustum(const Frustum* f, int cx, int cy, int cz) {
     return true;
 }
 
+typedef enum {
+    FRUSTUM_OUTSIDE = 0,
+    FRUSTUM_INTERSECT,
+    FRUSTUM_INSIDE
+} FrustumResult;
+
+// plane_mask holds the planes the box still straddles, children of an
+// intersecting box only need to be tested against those
+static inline FrustumResult frustum_classify_aabb(const Frustum* f, const vec3 box_min, const vec3 box_max, int* plane_mask) {
+    const Plane* planes[6] = {
+        &f->left_face,
+        &f->right_face,
+        &f->bottom_face,
+        &f->top_face,
+        &f->near_face,
+        &f->far_face
+    };
+
+    int mask = *plane_mask;
+    for (int i = 0; i < 6; ++i) {
+        if (!(mask & (1 << i))) continue;
+        const Plane* p = planes[i];
+
+        vec3 positive, negative;
+        for (int axis = 0; axis < 3; ++axis) {
+            positive[axis] = (p->normal[axis] >= 0.0f) ? box_max[axis] : box_min[axis];
+            negative[axis] = (p->normal[axis] >= 0.0f) ? box_min[axis] : box_max[axis];
+        }
+
+        if (glm_vec3_dot((float*)p->normal, positive) - p->distance < 0.0f) return FRUSTUM_OUTSIDE;
+        if (glm_vec3_dot((float*)p->normal, negative) - p->distance >= 0.0f) mask &= ~(1 << i);
+    }
+
+    *plane_mask = mask;
+    return mask ? FRUSTUM_INTERSECT : FRUSTUM_INSIDE;
+}
+
+// boxes in SoA layout so the batch test can load several of them per instruction
+typedef struct {
+    float* min_x;
+    float* min_y;
+    float* min_z;
+    float* max_x;
+    float* max_y;
+    float* max_z;
+    int count;
+    int capacity; // padded to FRUSTUM_BATCH_WIDTH
+} ChunkBounds;
+
+static inline void chunk_bounds_init(ChunkBounds* bounds, int count) {
+    int capacity = (count + FRUSTUM_BATCH_WIDTH - 1) / FRUSTUM_BATCH_WIDTH * FRUSTUM_BATCH_WIDTH;
+    float* data = calloc((size_t)capacity * 6, sizeof(float));
+
+    bounds->min_x = data;
+    bounds->min_y = data + capacity;
+    bounds->min_z = data + capacity * 2;
+    bounds->max_x = data + capacity * 3;
+    bounds->max_y = data + capacity * 4;
+    bounds->max_z = data + capacity * 5;
+    bounds->count = count;
+    bounds->capacity = capacity;
+}
+
+static inline void chunk_bounds_free(ChunkBounds* bounds) {
+    free(bounds->min_x);
+    memset(bounds, 0, sizeof(*bounds));
+}
+
+static inline void chunk_bounds_set(ChunkBounds* bounds, int index, const vec3 box_min, const vec3 box_max) {
+    bounds->min_x[index] = box_min[0];
+    bounds->min_y[index] = box_min[1];
+    bounds->min_z[index] = box_min[2];
+    bounds->max_x[index] = box_max[0];
+    bounds->max_y[index] = box_max[1];
+    bounds->max_z[index] = box_max[2];
+}
+
+// writes one bit per box into visible_mask ((count + 31) / 32 words), returns visible count
+static inline int frustum_cull_bounds(const Frustum* f, const ChunkBounds* bounds, uint32_t* visible_mask) {
+    const Plane* planes[6] = {
+        &f->left_face,
+        &f->right_face,
+        &f->bottom_face,
+        &f->top_face,
+        &f->near_face,
+        &f->far_face
+    };
+
+    // the positive vertex only depends on the plane, so pick whole arrays up front
+    const float* positive[6][3];
+    for (int p = 0; p < 6; ++p) {
+        positive[p][0] = planes[p]->normal[0] >= 0.0f ? bounds->max_x : bounds->min_x;
+        positive[p][1] = planes[p]->normal[1] >= 0.0f ? bounds->max_y : bounds->min_y;
+        positive[p][2] = planes[p]->normal[2] >= 0.0f ? bounds->max_z : bounds->min_z;
+    }
+
+    memset(visible_mask, 0, (size_t)(bounds->count + 31) / 32 * sizeof(uint32_t));
+    int visible = 0;
+
+    for (int i = 0; i < bounds->count; i += FRUSTUM_BATCH_WIDTH) {
+#if defined(__AVX__)
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m256 dist = _mm256_mul_ps(_mm256_set1_ps(planes[p]->normal[0]), _mm256_loadu_ps(positive[p][0] + i));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(planes[p]->normal[1]), _mm256_loadu_ps(positive[p][1] + i)));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(_mm256_set1_ps(planes[p]->normal[2]), _mm256_loadu_ps(positive[p][2] + i)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, _mm256_set1_ps(planes[p]->distance), _CMP_GE_OQ));
+        }
+        uint32_t bits = (uint32_t)_mm256_movemask_ps(inside);
+#elif defined(FRUSTUM_BATCH_SSE)
+        __m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+        for (int p = 0; p < 6; ++p) {
+            __m128 dist = _mm_mul_ps(_mm_set1_ps(planes[p]->normal[0]), _mm_loadu_ps(positive[p][0] + i));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p]->normal[1]), _mm_loadu_ps(positive[p][1] + i)));
+            dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p]->normal[2]), _mm_loadu_ps(positive[p][2] + i)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, _mm_set1_ps(planes[p]->distance)));
+        }
+        uint32_t bits = (uint32_t)_mm_movemask_ps(inside);
+#else
+        uint32_t bits = 1;
+        for (int p = 0; p < 6; ++p) {
+            float dist = planes[p]->normal[0] * positive[p][0][i]
+                       + planes[p]->normal[1] * positive[p][1][i]
+                       + planes[p]->normal[2] * positive[p][2][i];
+            if (dist < planes[p]->distance) bits = 0;
+        }
+#endif
+        // drop the padding lanes
+        int lanes = bounds->count - i;
+        if (lanes < FRUSTUM_BATCH_WIDTH) bits &= (1u << lanes) - 1u;
+
+        for (int lane = 0; lane < FRUSTUM_BATCH_WIDTH; ++lane) {
+            if (!(bits & (1u << lane))) continue;
+            int index = i + lane;
+            visible_mask[index / 32] |= 1u << (index % 32);
+            visible++;
+        }
+    }
+    return visible;
+}
+
 #endif // FRUSTRUM_H
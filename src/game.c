@@ -12,6 +12,7 @@ int game_init(Game* game) {
 	game->accumulator = 0.0f; // physics
     game->debug_wireframe_mode = false; // debug
     game->debug_backface_culling = true; // debug
+    game->debug_keep_mesh_data = false; // debug
 
 	// init glfw
 	if(!glfwInit()) {
@@ -63,16 +64,24 @@ int game_init(Game* game) {
 	shader_use(&myShader);
 	game->shader = myShader;
 
-	// textures atlas
+	// block textures, the 16x16 atlas split into array layers, decoded in the background
+	resource_loader_init(&game->loader);
 	char* texture_path = make_path("res/textures.png");
-	Texture atlas = texture_create(texture_path, GL_TEXTURE_2D);
-	texture_bind(&atlas, 0);
+	resource_loader_load_texture_array(&game->loader, &game->block_texture, texture_path, 16, 16);
+	texture_bind(&game->block_texture, 0);
 	shader_set_int(&myShader, "block_texture", 0);
 	
-	world_init(&game->world);
+	char* save_path = make_path(WORLD_SAVE_DIRECTORY);
+	world_init(&game->world, WORLD_DEFAULT_SEED, save_path);
+	free(save_path);
+	char* bounds_vert_path = make_path("res/shaders/bounds.vert");
+	char* bounds_frag_path = make_path("res/shaders/bounds.frag");
+	occlusion_init(&game->world.occlusion, MAX_WORLD_SIZE, bounds_vert_path, bounds_frag_path);
     world_update_light(&game->world);
 	world_update_mesh(&game->world);
-	player_init(&game->player);
+	vec3 spawn_position;
+	world_get_spawn(&game->world, spawn_position);
+	player_init(&game->player, spawn_position);
     return 0;
 }
 
@@ -87,6 +96,11 @@ void game_run(Game* game) {
 		game->alpha = game->accumulator / PHYSICS_TIMESTEP;
 		if (game->alpha > 1.0f) game->alpha = 1.0f;
 
+		// finish background loads
+		resource_loader_poll(&game->loader);
+		world_poll(&game->world, game->player.entity.position);
+		world_autosave(&game->world, game->delta_time);
+
 		// input
 		glfwPollEvents();
 		process_input(game->window);
@@ -115,7 +129,10 @@ void game_run(Game* game) {
 
 void game_close(Game* game) {
 	// player_unload(&game->player);
+	world_save(&game->world); // written while the world unloads
 	world_unload(&game->world);
+	resource_loader_free(&game->loader);
+	texture_destroy(&game->block_texture);
 
 	glfwDestroyWindow(game->window);
 	glfwTerminate();
@@ -8,6 +8,8 @@
 #include "world.h"
 #include "input.h"
 #include "entity.h"
+#include "texture.h"
+#include "resource_loader.h"
 
 typedef struct Game {
 	GLFWwindow* window;
@@ -25,12 +27,15 @@ typedef struct Game {
 	bool first_mouse;
 					  
 	Shader shader; // block shader
+	Texture block_texture;
+	ResourceLoader loader;
 	RenderContext ctx;
 	World world;
 	Player player;
 
     bool debug_wireframe_mode;
     bool debug_backface_culling;
+    bool debug_keep_mesh_data;
 } Game;
 
 int game_init(Game* game);
@@ -66,6 +66,13 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
             game->debug_backface_culling = !game->debug_backface_culling;
         } else if(key == GLFW_KEY_F3) {
             world_update_light(&game->world);
+        } else if(key == GLFW_KEY_F4) {
+            game->world.occlusion.enabled = !game->world.occlusion.enabled;
+        } else if(key == GLFW_KEY_F5) {
+            game->world.software_occlusion = !game->world.software_occlusion;
+        } else if(key == GLFW_KEY_F6) {
+            game->debug_keep_mesh_data = !game->debug_keep_mesh_data;
+            chunk_set_keep_mesh_data(game->debug_keep_mesh_data);
         } else if(key == GLFW_KEY_1) {
             game->player.selected_slot = 0;
         } else if(key == GLFW_KEY_2) {
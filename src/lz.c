@@ -0,0 +1,111 @@
+#include "lz.h"
+
+#include <string.h>
+
+static inline uint32_t lz_read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// lengths past the 15 a token nibble holds continue in 255 steps
+static bool lz_put_length(uint8_t* dst, size_t capacity, size_t* op, size_t length) {
+    while (length >= 255) {
+        if (*op >= capacity) return false;
+        dst[(*op)++] = 255;
+        length -= 255;
+    }
+    if (*op >= capacity) return false;
+    dst[(*op)++] = (uint8_t)length;
+    return true;
+}
+
+static bool lz_put_sequence(uint8_t* dst, size_t capacity, size_t* op,
+                            const uint8_t* literals, size_t literal_count, size_t offset, size_t match) {
+    if (*op >= capacity) return false;
+    size_t match_code = match ? match - LZ_MIN_MATCH : 0;
+    dst[(*op)++] = (uint8_t)((literal_count < 15 ? literal_count : 15) << 4 | (match_code < 15 ? match_code : 15));
+    if (literal_count >= 15 && !lz_put_length(dst, capacity, op, literal_count - 15)) return false;
+
+    if (capacity - *op < literal_count) return false;
+    memcpy(dst + *op, literals, literal_count);
+    *op += literal_count;
+
+    if (!match) return true; // the last sequence is literals only
+    if (capacity - *op < 2) return false;
+    dst[(*op)++] = (uint8_t)offset;
+    dst[(*op)++] = (uint8_t)(offset >> 8);
+    return match_code < 15 || lz_put_length(dst, capacity, op, match_code - 15);
+}
+
+size_t lz_compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    uint32_t table[1 << LZ_HASH_BITS]; // position + 1 of the last 4 bytes with each hash
+    memset(table, 0, sizeof(table));
+
+    size_t ip = 0, anchor = 0, op = 0;
+    while (ip + LZ_MIN_MATCH <= size) {
+        uint32_t sequence = lz_read32(src + ip);
+        uint32_t h = lz_hash(sequence);
+        size_t candidate = table[h];
+        table[h] = (uint32_t)(ip + 1);
+
+        if (!candidate || ip - (candidate - 1) > LZ_MAX_OFFSET || lz_read32(src + candidate - 1) != sequence) {
+            ip++;
+            continue;
+        }
+
+        size_t ref = candidate - 1;
+        size_t match = LZ_MIN_MATCH;
+        while (ip + match < size && src[ref + match] == src[ip + match]) match++;
+
+        if (!lz_put_sequence(dst, capacity, &op, src + anchor, ip - anchor, ip - ref, match)) return 0;
+        ip += match;
+        anchor = ip;
+    }
+
+    if (!lz_put_sequence(dst, capacity, &op, src + anchor, size - anchor, 0, 0)) return 0;
+    return op;
+}
+
+static bool lz_get_length(const uint8_t* src, size_t size, size_t* ip, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*ip >= size) return false;
+        byte = src[(*ip)++];
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t expected) {
+    size_t ip = 0, op = 0;
+    while (ip < size) {
+        uint8_t token = src[ip++];
+
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !lz_get_length(src, size, &ip, &literal_count)) return false;
+        if (size - ip < literal_count || expected - op < literal_count) return false;
+        memcpy(dst + op, src + ip, literal_count);
+        ip += literal_count;
+        op += literal_count;
+
+        if (ip == size) break; // literals only, the block is done
+
+        if (size - ip < 2) return false;
+        size_t offset = (size_t)src[ip] | (size_t)src[ip + 1] << 8;
+        ip += 2;
+        size_t match = (token & 15) + LZ_MIN_MATCH;
+        if ((token & 15) == 15 && !lz_get_length(src, size, &ip, &match)) return false;
+        if (offset == 0 || offset > op || expected - op < match) return false;
+
+        // byte by byte, a match may overlap the bytes it produces
+        const uint8_t* ref = dst + op - offset;
+        for (size_t i = 0; i < match; i++) dst[op + i] = ref[i];
+        op += match;
+    }
+    return op == expected;
+}
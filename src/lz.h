@@ -0,0 +1,20 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// small byte oriented lz77 in the lz4 block style: a token with literal and
+// match lengths, the literals, then a 16-bit back offset; no entropy stage,
+// so decoding is a tight copy loop
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12
+#define LZ_BOUND(size) ((size) + (size) / 255 + 16) // worst case output for incompressible input
+
+size_t lz_compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity); // 0 if it does not fit
+bool lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t expected); // true if exactly expected bytes came out
+
+#endif // LZ_H
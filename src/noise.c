@@ -0,0 +1,380 @@
+#include "noise.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// the 12 cube edge directions, padded to 16 so a hash picks one with & 15
+static const float noise_gradient_directions[16][3] = {
+    { 1,  1,  0}, {-1,  1,  0}, { 1, -1,  0}, {-1, -1,  0},
+    { 1,  0,  1}, {-1,  0,  1}, { 1,  0, -1}, {-1,  0, -1},
+    { 0,  1,  1}, { 0, -1,  1}, { 0,  1, -1}, { 0, -1, -1},
+    { 1,  1,  0}, { 0, -1,  1}, {-1,  1,  0}, { 0, -1, -1},
+};
+
+static uint64_t noise_splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void noise_context_init(NoiseContext* ctx, uint64_t seed) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->seed = seed;
+
+    // fisher-yates shuffle of 0..255 driven by the seed
+    int perm[256];
+    for (int i = 0; i < 256; i++) perm[i] = i;
+
+    uint64_t state = seed;
+    for (int i = 255; i > 0; i--) {
+        int j = (int)(noise_splitmix64(&state) % (uint64_t)(i + 1));
+        int t = perm[i];
+        perm[i] = perm[j];
+        perm[j] = t;
+    }
+
+    for (int i = 0; i < 512; i++) {
+        ctx->perm[i] = perm[i & 255]; // duplicated so hashing never wraps
+        const float* g = noise_gradient_directions[ctx->perm[i] & 15];
+        ctx->gradient_x[i] = g[0];
+        ctx->gradient_y[i] = g[1];
+        ctx->gradient_z[i] = g[2];
+    }
+}
+
+// truncation based floor, shared by every path so they agree on all inputs
+static inline float noise_floor(float x) {
+    float f = (float)(int)x;
+    return f > x ? f - 1.0f : f;
+}
+
+static inline float noise_fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline float noise_lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+// gradient of the corner hashed to slot i, one component is always zero so
+// this equals the sign-selected sum the batch paths compute
+static inline float noise_grad(const NoiseContext* ctx, int i, float x, float y, float z) {
+    return ctx->gradient_x[i] * x + ctx->gradient_y[i] * y + ctx->gradient_z[i] * z;
+}
+
+float noise_perlin_3d(const NoiseContext* ctx, float x, float y, float z) {
+    const int* p = ctx->perm;
+    float fx = noise_floor(x);
+    float fy = noise_floor(y);
+    float fz = noise_floor(z);
+
+    int X = (int)fx & 255;
+    int Y = (int)fy & 255;
+    int Z = (int)fz & 255;
+
+    x -= fx;
+    y -= fy;
+    z -= fz;
+
+    float u = noise_fade(x);
+    float v = noise_fade(y);
+    float w = noise_fade(z);
+
+    int A  = p[X] + Y;
+    int AA = p[A] + Z;
+    int AB = p[A + 1] + Z;
+    int B  = p[X + 1] + Y;
+    int BA = p[B] + Z;
+    int BB = p[B + 1] + Z;
+
+    return noise_lerp(
+        noise_lerp(
+            noise_lerp(noise_grad(ctx, AA, x, y, z),
+                       noise_grad(ctx, BA, x - 1.0f, y, z), u),
+            noise_lerp(noise_grad(ctx, AB, x, y - 1.0f, z),
+                       noise_grad(ctx, BB, x - 1.0f, y - 1.0f, z), u),
+            v),
+        noise_lerp(
+            noise_lerp(noise_grad(ctx, AA + 1, x, y, z - 1.0f),
+                       noise_grad(ctx, BA + 1, x - 1.0f, y, z - 1.0f), u),
+            noise_lerp(noise_grad(ctx, AB + 1, x, y - 1.0f, z - 1.0f),
+                       noise_grad(ctx, BB + 1, x - 1.0f, y - 1.0f, z - 1.0f), u),
+            v),
+        w);
+}
+
+float noise_fbm(const NoiseContext* ctx, float x, float y, float z, int octaves) {
+    float total = 0.0f;
+    float frequency = 1.0f;
+    float amplitude = 1.0f;
+    float max_value = 0.0f;
+
+    for (int i = 0; i < octaves; i++) {
+        total += noise_perlin_3d(ctx, x * frequency, y * frequency, z * frequency) * amplitude;
+        max_value += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+
+    return total / max_value; // normalize to [-1, 1]
+}
+
+#if NOISE_BATCH_WIDTH == 8
+
+static inline __m256 floor8(__m256 x) {
+    __m256 f = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(x));
+    __m256 above = _mm256_cmp_ps(f, x, _CMP_GT_OQ);
+    return _mm256_sub_ps(f, _mm256_and_ps(above, _mm256_set1_ps(1.0f)));
+}
+
+static inline __m256 fade8(__m256 t) {
+    __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+}
+
+static inline __m256 lerp8(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+static inline __m256 grad8(__m256i hash, __m256 x, __m256 y, __m256 z) {
+    __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+    __m256 lt8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+    __m256 lt4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+    __m256 use_x = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+
+    __m256 u = _mm256_blendv_ps(y, x, lt8);
+    __m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, use_x), y, lt4);
+
+    // negation flips the sign bit, exactly like unary minus
+    __m256 sign_u = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+    __m256 sign_v = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+    return _mm256_add_ps(_mm256_xor_ps(u, sign_u), _mm256_xor_ps(v, sign_v));
+}
+
+static inline __m256i gather8(const int* p, __m256i index) {
+    return _mm256_i32gather_epi32(p, index, 4);
+}
+
+static __m256 perlin8(const int* p, __m256 x, __m256 y, __m256 z) {
+    __m256 fx = floor8(x);
+    __m256 fy = floor8(y);
+    __m256 fz = floor8(z);
+
+    __m256i mask = _mm256_set1_epi32(255);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i X = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+    __m256i Y = _mm256_and_si256(_mm256_cvttps_epi32(fy), mask);
+    __m256i Z = _mm256_and_si256(_mm256_cvttps_epi32(fz), mask);
+
+    x = _mm256_sub_ps(x, fx);
+    y = _mm256_sub_ps(y, fy);
+    z = _mm256_sub_ps(z, fz);
+
+    __m256 u = fade8(x);
+    __m256 v = fade8(y);
+    __m256 w = fade8(z);
+
+    __m256i A  = _mm256_add_epi32(gather8(p, X), Y);
+    __m256i AA = _mm256_add_epi32(gather8(p, A), Z);
+    __m256i AB = _mm256_add_epi32(gather8(p, _mm256_add_epi32(A, one)), Z);
+    __m256i B  = _mm256_add_epi32(gather8(p, _mm256_add_epi32(X, one)), Y);
+    __m256i BA = _mm256_add_epi32(gather8(p, B), Z);
+    __m256i BB = _mm256_add_epi32(gather8(p, _mm256_add_epi32(B, one)), Z);
+
+    __m256 ones = _mm256_set1_ps(1.0f);
+    __m256 x1 = _mm256_sub_ps(x, ones);
+    __m256 y1 = _mm256_sub_ps(y, ones);
+    __m256 z1 = _mm256_sub_ps(z, ones);
+
+    return lerp8(
+        lerp8(
+            lerp8(grad8(gather8(p, AA), x, y, z),
+                  grad8(gather8(p, BA), x1, y, z), u),
+            lerp8(grad8(gather8(p, AB), x, y1, z),
+                  grad8(gather8(p, BB), x1, y1, z), u),
+            v),
+        lerp8(
+            lerp8(grad8(gather8(p, _mm256_add_epi32(AA, one)), x, y, z1),
+                  grad8(gather8(p, _mm256_add_epi32(BA, one)), x1, y, z1), u),
+            lerp8(grad8(gather8(p, _mm256_add_epi32(AB, one)), x, y1, z1),
+                  grad8(gather8(p, _mm256_add_epi32(BB, one)), x1, y1, z1), u),
+            v),
+        w);
+}
+
+#define noise_batch_kernel(p, x, y, z) perlin8(p, x, y, z)
+#define batch_load _mm256_loadu_ps
+#define batch_store _mm256_storeu_ps
+#define batch_add _mm256_add_ps
+#define batch_mul _mm256_mul_ps
+#define batch_set1 _mm256_set1_ps
+typedef __m256 BatchFloat;
+
+#elif defined(NOISE_BATCH_SSE)
+
+static inline __m128 blend4(__m128 mask, __m128 a, __m128 b) { // mask ? a : b
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 floor4(__m128 x) {
+    __m128 f = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    __m128 above = _mm_cmpgt_ps(f, x);
+    return _mm_sub_ps(f, _mm_and_ps(above, _mm_set1_ps(1.0f)));
+}
+
+static inline __m128 fade4(__m128 t) {
+    __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+}
+
+static inline __m128 lerp4(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+static inline __m128 grad4(__m128i hash, __m128 x, __m128 y, __m128 z) {
+    __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+    __m128 lt8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+    __m128 lt4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+    __m128 use_x = _mm_castsi128_ps(_mm_or_si128(
+        _mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+
+    __m128 u = blend4(lt8, x, y);
+    __m128 v = blend4(lt4, y, blend4(use_x, x, z));
+
+    // negation flips the sign bit, exactly like unary minus
+    __m128 sign_u = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    __m128 sign_v = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    return _mm_add_ps(_mm_xor_ps(u, sign_u), _mm_xor_ps(v, sign_v));
+}
+
+static __m128 perlin4(const int* p, __m128 x, __m128 y, __m128 z) {
+    __m128 fx = floor4(x);
+    __m128 fy = floor4(y);
+    __m128 fz = floor4(z);
+
+    int X[4], Y[4], Z[4];
+    _mm_storeu_si128((__m128i*)X, _mm_cvttps_epi32(fx));
+    _mm_storeu_si128((__m128i*)Y, _mm_cvttps_epi32(fy));
+    _mm_storeu_si128((__m128i*)Z, _mm_cvttps_epi32(fz));
+
+    // sse2 has no gather, hash each lane
+    int h[8][4];
+    for (int i = 0; i < 4; i++) {
+        int xi = X[i] & 255, yi = Y[i] & 255, zi = Z[i] & 255;
+        int A  = p[xi] + yi;
+        int AA = p[A] + zi;
+        int AB = p[A + 1] + zi;
+        int B  = p[xi + 1] + yi;
+        int BA = p[B] + zi;
+        int BB = p[B + 1] + zi;
+        h[0][i] = p[AA];     h[1][i] = p[BA];
+        h[2][i] = p[AB];     h[3][i] = p[BB];
+        h[4][i] = p[AA + 1]; h[5][i] = p[BA + 1];
+        h[6][i] = p[AB + 1]; h[7][i] = p[BB + 1];
+    }
+
+    x = _mm_sub_ps(x, fx);
+    y = _mm_sub_ps(y, fy);
+    z = _mm_sub_ps(z, fz);
+
+    __m128 u = fade4(x);
+    __m128 v = fade4(y);
+    __m128 w = fade4(z);
+
+    __m128 ones = _mm_set1_ps(1.0f);
+    __m128 x1 = _mm_sub_ps(x, ones);
+    __m128 y1 = _mm_sub_ps(y, ones);
+    __m128 z1 = _mm_sub_ps(z, ones);
+
+#define HASH(n) _mm_loadu_si128((const __m128i*)h[n])
+    __m128 result = lerp4(
+        lerp4(
+            lerp4(grad4(HASH(0), x, y, z),
+                  grad4(HASH(1), x1, y, z), u),
+            lerp4(grad4(HASH(2), x, y1, z),
+                  grad4(HASH(3), x1, y1, z), u),
+            v),
+        lerp4(
+            lerp4(grad4(HASH(4), x, y, z1),
+                  grad4(HASH(5), x1, y, z1), u),
+            lerp4(grad4(HASH(6), x, y1, z1),
+                  grad4(HASH(7), x1, y1, z1), u),
+            v),
+        w);
+#undef HASH
+    return result;
+}
+
+#define noise_batch_kernel(p, x, y, z) perlin4(p, x, y, z)
+#define batch_load _mm_loadu_ps
+#define batch_store _mm_storeu_ps
+#define batch_add _mm_add_ps
+#define batch_mul _mm_mul_ps
+#define batch_set1 _mm_set1_ps
+typedef __m128 BatchFloat;
+
+#endif
+
+void noise_perlin_3d_batch(const NoiseContext* ctx, const float* x, const float* y, const float* z, float* out, int count) {
+    int i = 0;
+#if NOISE_BATCH_WIDTH > 1
+    for (; i + NOISE_BATCH_WIDTH <= count; i += NOISE_BATCH_WIDTH) {
+        batch_store(out + i, noise_batch_kernel(ctx->perm, batch_load(x + i), batch_load(y + i), batch_load(z + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = noise_perlin_3d(ctx, x[i], y[i], z[i]);
+    }
+}
+
+void noise_fbm_batch(const NoiseContext* ctx, const float* x, const float* y, const float* z, float* out, int count, int octaves) {
+    int i = 0;
+#if NOISE_BATCH_WIDTH > 1
+    for (; i + NOISE_BATCH_WIDTH <= count; i += NOISE_BATCH_WIDTH) {
+        BatchFloat bx = batch_load(x + i);
+        BatchFloat by = batch_load(y + i);
+        BatchFloat bz = batch_load(z + i);
+        BatchFloat total = batch_set1(0.0f);
+        float frequency = 1.0f;
+        float amplitude = 1.0f;
+        float max_value = 0.0f;
+
+        for (int o = 0; o < octaves; o++) {
+            BatchFloat f = batch_set1(frequency);
+            BatchFloat n = noise_batch_kernel(ctx->perm, batch_mul(bx, f), batch_mul(by, f), batch_mul(bz, f));
+            total = batch_add(total, batch_mul(n, batch_set1(amplitude)));
+            max_value += amplitude;
+            amplitude *= 0.5f;
+            frequency *= 2.0f;
+        }
+
+        // divide per lane, the scalar path divides too
+        float lanes[NOISE_BATCH_WIDTH];
+        batch_store(lanes, total);
+        for (int l = 0; l < NOISE_BATCH_WIDTH; l++) {
+            out[i + l] = lanes[l] / max_value;
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = noise_fbm(ctx, x[i], y[i], z[i], octaves);
+    }
+}
+
+void noise_fbm_grid_2d(const NoiseContext* ctx, int origin_x, int origin_z, int size_x, int size_z,
+                       float scale, float y, int octaves, float* out) {
+    float xs[256], ys[256], zs[256]; // one row at a time
+    for (int i = 0; i < size_x; i++) {
+        for (int k0 = 0; k0 < size_z; k0 += 256) {
+            int count = size_z - k0 < 256 ? size_z - k0 : 256;
+            for (int k = 0; k < count; k++) {
+                xs[k] = (origin_x + i) * scale;
+                ys[k] = y;
+                zs[k] = (origin_z + k0 + k) * scale;
+            }
+            noise_fbm_batch(ctx, xs, ys, zs, out + i * size_z + k0, count, octaves);
+        }
+    }
+}
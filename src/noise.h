@@ -0,0 +1,42 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NOISE_BATCH_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NOISE_BATCH_SSE
+#define NOISE_BATCH_WIDTH 4
+#else
+#define NOISE_BATCH_WIDTH 1
+#endif
+
+// permutation and gradient tables derived from a seed; never written after
+// noise_context_init, so one context can be shared by any number of threads
+typedef struct {
+    uint64_t seed;
+    int perm[512]; // a shuffle of 0..255, repeated
+    float gradient_x[512]; // gradient picked by perm[i], per slot
+    float gradient_y[512];
+    float gradient_z[512];
+} NoiseContext;
+
+void noise_context_init(NoiseContext* ctx, uint64_t seed);
+
+// improved perlin noise, every batch path performs the same float operations
+// in the same order as the scalar one so results match whichever path runs
+// (build without fp contraction)
+float noise_perlin_3d(const NoiseContext* ctx, float x, float y, float z);
+float noise_fbm(const NoiseContext* ctx, float x, float y, float z, int octaves);
+
+void noise_perlin_3d_batch(const NoiseContext* ctx, const float* x, const float* y, const float* z, float* out, int count);
+void noise_fbm_batch(const NoiseContext* ctx, const float* x, const float* y, const float* z, float* out, int count, int octaves);
+
+// out[i * size_z + k] = noise_fbm((origin_x + i) * scale, y, (origin_z + k) * scale)
+void noise_fbm_grid_2d(const NoiseContext* ctx, int origin_x, int origin_z, int size_x, int size_z,
+                       float scale, float y, int octaves, float* out);
+
+#endif // NOISE_H
@@ -0,0 +1,169 @@
+#include "occlusion_buffer.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define OCCLUSION_BUFFER_SSE
+#endif
+
+// points closer than this to the camera plane are not projected
+#define MIN_DEPTH 0.05f
+
+typedef struct {
+    float x, y; // buffer pixels
+    float w;    // view depth
+} ScreenPoint;
+
+static bool project_point(const mat4 m, const vec3 p, ScreenPoint* out) {
+    float x = m[0][0] * p[0] + m[1][0] * p[1] + m[2][0] * p[2] + m[3][0];
+    float y = m[0][1] * p[0] + m[1][1] * p[1] + m[2][1] * p[2] + m[3][1];
+    float w = m[0][3] * p[0] + m[1][3] * p[1] + m[2][3] * p[2] + m[3][3];
+    if (w < MIN_DEPTH) return false;
+
+    out->x = (x / w * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH;
+    out->y = (y / w * 0.5f + 0.5f) * OCCLUSION_BUFFER_HEIGHT;
+    out->w = w;
+    return true;
+}
+
+void occlusion_buffer_clear(OcclusionBuffer* buffer, const mat4 projection, const mat4 view) {
+    glm_mat4_mul((vec4*)projection, (vec4*)view, buffer->view_projection);
+
+    for (int i = 0; i < OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT; ++i) {
+        buffer->depth[i] = FLT_MAX;
+    }
+}
+
+void occlusion_buffer_add_quad(OcclusionBuffer* buffer, const vec3 corners[4]) {
+    ScreenPoint p[4];
+    for (int i = 0; i < 4; ++i) {
+        // clipped occluders are skipped, a partial one could cover too much
+        if (!project_point(buffer->view_projection, corners[i], &p[i])) return;
+    }
+
+    float area = 0.0f;
+    float depth = 0.0f;
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+    for (int i = 0; i < 4; ++i) {
+        const ScreenPoint* a = &p[i];
+        const ScreenPoint* b = &p[(i + 1) % 4];
+        area += a->x * b->y - b->x * a->y;
+
+        // the farthest corner, so the quad never occludes more than it really does
+        depth = fmaxf(depth, a->w);
+        min_x = fminf(min_x, a->x);
+        min_y = fminf(min_y, a->y);
+        max_x = fmaxf(max_x, a->x);
+        max_y = fmaxf(max_y, a->y);
+    }
+    if (area == 0.0f) return;
+
+    // edge functions e = A * x + B * y + C, positive inside. C is shrunk by the
+    // pixel's half extent so only pixels covered entirely get written
+    float edge_a[4], edge_b[4], edge_c[4];
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    for (int i = 0; i < 4; ++i) {
+        const ScreenPoint* a = &p[i];
+        const ScreenPoint* b = &p[(i + 1) % 4];
+        edge_a[i] = -(b->y - a->y) * sign;
+        edge_b[i] = (b->x - a->x) * sign;
+        edge_c[i] = -(edge_a[i] * a->x + edge_b[i] * a->y) - 0.5f * (fabsf(edge_a[i]) + fabsf(edge_b[i]));
+    }
+
+    int x0 = (int)floorf(min_x);
+    int y0 = (int)floorf(min_y);
+    int x1 = (int)ceilf(max_x);
+    int y1 = (int)ceilf(max_y);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > OCCLUSION_BUFFER_WIDTH - 1) x1 = OCCLUSION_BUFFER_WIDTH - 1;
+    if (y1 > OCCLUSION_BUFFER_HEIGHT - 1) y1 = OCCLUSION_BUFFER_HEIGHT - 1;
+    if (x0 > x1 || y0 > y1) return;
+    x0 &= ~3; // whole groups of 4, pixels outside the quad fail the edge test
+
+    for (int y = y0; y <= y1; ++y) {
+        float* row = &buffer->depth[y * OCCLUSION_BUFFER_WIDTH];
+        float py = y + 0.5f;
+
+#if defined(OCCLUSION_BUFFER_SSE)
+        __m128 lane_x = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        __m128 quad_depth = _mm_set1_ps(depth);
+        __m128 zero = _mm_setzero_ps();
+
+        for (int x = x0; x <= x1; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lane_x);
+            __m128 inside = _mm_cmpeq_ps(zero, zero);
+            for (int e = 0; e < 4; ++e) {
+                __m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_a[e]), px),
+                    _mm_set1_ps(edge_b[e] * py + edge_c[e]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(value, zero));
+            }
+
+            __m128 current = _mm_loadu_ps(row + x);
+            __m128 nearest = _mm_min_ps(current, quad_depth);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+        }
+#else
+        for (int x = x0; x <= x1; ++x) {
+            float px = x + 0.5f;
+            bool inside = true;
+            for (int e = 0; e < 4; ++e) {
+                if (edge_a[e] * px + (edge_b[e] * py + edge_c[e]) < 0.0f) inside = false;
+            }
+            if (inside && depth < row[x]) row[x] = depth;
+        }
+#endif
+    }
+}
+
+bool occlusion_buffer_test_aabb(const OcclusionBuffer* buffer, const vec3 box_min, const vec3 box_max) {
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+    float nearest = FLT_MAX;
+
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = {
+            (i & 1) ? box_max[0] : box_min[0],
+            (i & 2) ? box_max[1] : box_min[1],
+            (i & 4) ? box_max[2] : box_min[2]
+        };
+
+        ScreenPoint p;
+        if (!project_point(buffer->view_projection, corner, &p)) return true; // box reaches the camera
+
+        min_x = fminf(min_x, p.x);
+        min_y = fminf(min_y, p.y);
+        max_x = fmaxf(max_x, p.x);
+        max_y = fmaxf(max_y, p.y);
+        nearest = fminf(nearest, p.w);
+    }
+
+    int x0 = (int)floorf(min_x);
+    int y0 = (int)floorf(min_y);
+    int x1 = (int)floorf(max_x);
+    int y1 = (int)floorf(max_y);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > OCCLUSION_BUFFER_WIDTH - 1) x1 = OCCLUSION_BUFFER_WIDTH - 1;
+    if (y1 > OCCLUSION_BUFFER_HEIGHT - 1) y1 = OCCLUSION_BUFFER_HEIGHT - 1;
+    if (x0 > x1 || y0 > y1) return true; // off screen, left to the frustum test
+    x0 &= ~3; // extra pixels only make the test more conservative
+
+    for (int y = y0; y <= y1; ++y) {
+        const float* row = &buffer->depth[y * OCCLUSION_BUFFER_WIDTH];
+
+#if defined(OCCLUSION_BUFFER_SSE)
+        __m128 box_depth = _mm_set1_ps(nearest);
+        for (int x = x0; x <= x1; x += 4) {
+            if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), box_depth))) return true;
+        }
+#else
+        for (int x = x0; x <= x1; ++x) {
+            if (row[x] >= nearest) return true;
+        }
+#endif
+    }
+    return false;
+}
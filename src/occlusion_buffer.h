@@ -0,0 +1,22 @@
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include <cglm/cglm.h>
+#include <stdbool.h>
+
+#define OCCLUSION_BUFFER_WIDTH 256  // must be a multiple of 4
+#define OCCLUSION_BUFFER_HEIGHT 128
+
+// low resolution CPU depth buffer, occluder quads are rasterized into it and
+// chunk bounding boxes tested against it before anything is submitted to the GPU
+typedef struct {
+    float depth[OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT]; // view depth of the nearest occluder
+    mat4 view_projection;
+} OcclusionBuffer;
+
+void occlusion_buffer_clear(OcclusionBuffer* buffer, const mat4 projection, const mat4 view);
+// corners of a planar convex quad in world space, in either winding
+void occlusion_buffer_add_quad(OcclusionBuffer* buffer, const vec3 corners[4]);
+bool occlusion_buffer_test_aabb(const OcclusionBuffer* buffer, const vec3 box_min, const vec3 box_max);
+
+#endif // OCCLUSION_BUFFER_H
@@ -0,0 +1,138 @@
+#include "occlusion_query.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// boxes closer than this to the camera may get clipped by the near plane
+#define CAMERA_MARGIN 1.0f
+// boxes are pushed this far past the chunk bounds, so border faces drawn
+// exactly on the bounds do not hide the box from its own chunk
+#define BOX_MARGIN 0.05f
+
+static const float cube_vertices[] = {
+    0.0f, 0.0f, 0.0f,
+    1.0f, 0.0f, 0.0f,
+    1.0f, 1.0f, 0.0f,
+    0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 1.0f,
+    1.0f, 0.0f, 1.0f,
+    1.0f, 1.0f, 1.0f,
+    0.0f, 1.0f, 1.0f
+};
+
+static const unsigned char cube_indices[] = {
+    0, 1, 2, 2, 3, 0, // -Z
+    4, 6, 5, 6, 4, 7, // +Z
+    0, 3, 7, 7, 4, 0, // -X
+    1, 5, 6, 6, 2, 1, // +X
+    0, 4, 5, 5, 1, 0, // -Y
+    3, 2, 6, 6, 7, 3  // +Y
+};
+
+void occlusion_init(OcclusionQueries* oq, int count, const char* vertex_path, const char* fragment_path) {
+    memset(oq, 0, sizeof(*oq));
+
+    oq->shader = shader_create(vertex_path, fragment_path);
+    oq->count = count;
+    oq->queries = malloc(count * sizeof(GLuint));
+    oq->issued_frame = calloc(count, sizeof(unsigned int));
+    oq->frame = 1;
+    glGenQueries(count, oq->queries);
+
+    glGenVertexArrays(1, &oq->vao);
+    glGenBuffers(1, &oq->vbo);
+    glGenBuffers(1, &oq->ebo);
+
+    glBindVertexArray(oq->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, oq->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, oq->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cube_indices), cube_indices, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+void occlusion_free(OcclusionQueries* oq) {
+    if (oq->queries) glDeleteQueries(oq->count, oq->queries);
+    if (oq->vao) glDeleteVertexArrays(1, &oq->vao);
+    if (oq->vbo) glDeleteBuffers(1, &oq->vbo);
+    if (oq->ebo) glDeleteBuffers(1, &oq->ebo);
+    if (oq->shader.ID) glDeleteProgram(oq->shader.ID);
+
+    free(oq->queries);
+    free(oq->issued_frame);
+    memset(oq, 0, sizeof(*oq));
+}
+
+void occlusion_begin_frame(OcclusionQueries* oq) {
+    oq->frame++;
+}
+
+bool occlusion_begin_conditional(OcclusionQueries* oq, int index, const vec3 box_min, const vec3 box_max, const vec3 camera) {
+    if (!oq->enabled || !oq->queries) return false;
+
+    // only results from the previous frame, anything older is stale
+    if (oq->issued_frame[index] != oq->frame - 1) return false;
+
+    // the box around the camera is never reliably rasterized
+    bool near_camera = true;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (camera[axis] < box_min[axis] - CAMERA_MARGIN || camera[axis] > box_max[axis] + CAMERA_MARGIN) {
+            near_camera = false;
+        }
+    }
+    if (near_camera) return false;
+
+    // no wait, a result that is not ready yet renders the chunk instead of stalling
+    glBeginConditionalRender(oq->queries[index], GL_QUERY_NO_WAIT);
+    return true;
+}
+
+void occlusion_end_conditional(void) {
+    glEndConditionalRender();
+}
+
+void occlusion_issue_begin(OcclusionQueries* oq, const RenderContext* ctx) {
+    shader_use(&oq->shader);
+    shader_set_mat4(&oq->shader, "projection", ctx->projection);
+    shader_set_mat4(&oq->shader, "view", ctx->view);
+
+    // test against the depth buffer without touching it
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    oq->cull_face = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_CULL_FACE);
+    glGetIntegerv(GL_DEPTH_FUNC, &oq->depth_func);
+    glDepthFunc(GL_LEQUAL);
+
+    glBindVertexArray(oq->vao);
+}
+
+void occlusion_issue(OcclusionQueries* oq, int index, const vec3 box_min, const vec3 box_max) {
+    mat4 model;
+    vec3 origin, size;
+    for (int axis = 0; axis < 3; ++axis) {
+        origin[axis] = box_min[axis] - BOX_MARGIN;
+        size[axis] = box_max[axis] - box_min[axis] + 2.0f * BOX_MARGIN;
+    }
+    glm_mat4_identity(model);
+    glm_translate(model, origin);
+    glm_scale(model, size);
+    shader_set_mat4(&oq->shader, "model", model);
+
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, oq->queries[index]);
+    glDrawElements(GL_TRIANGLES, sizeof(cube_indices), GL_UNSIGNED_BYTE, 0);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+    oq->issued_frame[index] = oq->frame;
+}
+
+void occlusion_issue_end(OcclusionQueries* oq) {
+    glBindVertexArray(0);
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(oq->depth_func);
+    if (oq->cull_face) glEnable(GL_CULL_FACE);
+}
@@ -0,0 +1,43 @@
+#ifndef OCCLUSION_QUERY_H
+#define OCCLUSION_QUERY_H
+
+#include <glad.h>
+#include <cglm/cglm.h>
+#include <stdbool.h>
+
+#include "shader.h"
+#include "render_context.h"
+
+// one GL occlusion query per chunk, the bounding box is tested after the opaque
+// pass and the next frame draws the chunk conditionally on the result
+typedef struct {
+    bool enabled;
+
+    Shader shader;
+    GLuint vao;
+    GLuint vbo;
+    GLuint ebo;
+
+    GLuint* queries;
+    unsigned int* issued_frame; // frame each query was last issued in, 0 if never
+    unsigned int frame;
+    int count;
+
+    GLboolean cull_face; // restored after issuing
+    GLint depth_func;
+
+} OcclusionQueries;
+
+void occlusion_init(OcclusionQueries* oq, int count, const char* vertex_path, const char* fragment_path);
+void occlusion_free(OcclusionQueries* oq);
+void occlusion_begin_frame(OcclusionQueries* oq);
+
+// wraps the chunk's draw in conditional rendering when last frame's query can be used
+bool occlusion_begin_conditional(OcclusionQueries* oq, int index, const vec3 box_min, const vec3 box_max, const vec3 camera);
+void occlusion_end_conditional(void);
+
+void occlusion_issue_begin(OcclusionQueries* oq, const RenderContext* ctx);
+void occlusion_issue(OcclusionQueries* oq, int index, const vec3 box_min, const vec3 box_max);
+void occlusion_issue_end(OcclusionQueries* oq);
+
+#endif // OCCLUSION_QUERY_H
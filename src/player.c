@@ -3,9 +3,8 @@
 
 #define CAMERA_OFFSET 0.5f
 
-void player_init(Player* player) {
+void player_init(Player* player, vec3 spawn_position) {
 	vec3 collision_box = {0.5f, 1.8f, 0.5f};
-	vec3 spawn_position = {2.0f, 6.0f, 6.0f};
 	vec3 up = {0.0f, 1.0f, 0.0f};
 
 	entity_init(&player->entity, spawn_position, 10.0f, collision_box[0], collision_box[1], collision_box[2]);
@@ -34,14 +33,11 @@ void player_update(Player* player, Game* game) {
 	camera_get_view_matrix(&game->player.camera, view);
 	// shader_set_mat4(&myShader, "view", view);
 	memcpy(game->ctx.view, view, sizeof(mat4));
+	glm_vec3_copy(game->player.camera.position, game->ctx.camera_position);
 		
-	Frustum frustum = create_frustum_from_camera(
-		&game->player.camera, 
-		game->aspect, 
-		player->camera.fov_rad, 
-		player->camera.near_plane, 
-		player->camera.far_plane
-	);
+	mat4 view_projection;
+	glm_mat4_mul(projection, view, view_projection);
+	Frustum frustum = create_frustum_from_matrix(view_projection);
 	game->ctx.frustum = frustum;
 
 	// Update camera position directly from player
@@ -183,39 +179,7 @@ void player_place_block(Game* game) {
 					hit_coord[0], hit_coord[1], hit_coord[2]) != selected_block) {
 
 			world_set_block(&game->world, 
-					hit_coord[0], hit_coord[1], hit_coord[2], selected_block);
-
-            // world_rebuild(&game->world);
-            ivec3 chunk_coord = {
-                hit_coord[0] / CHUNK_SIZE,
-                hit_coord[1] / CHUNK_SIZE,
-                hit_coord[2] / CHUNK_SIZE
-            };
-
-            ivec3 local_coord = {
-                hit_coord[0] % CHUNK_SIZE,
-                hit_coord[1] % CHUNK_SIZE,
-                hit_coord[2] % CHUNK_SIZE
-            };
-			
-            // check neighbors
-            if(local_coord[0] == 0 && chunk_coord[0] > 0) { // x
-                game->world.chunks[world_get_chunk_index(chunk_coord[0] - 1, chunk_coord[1], chunk_coord[2])].dirty = true;
-            } else if(local_coord[0] == CHUNK_SIZE - 1&& chunk_coord[0] < WORLD_SIZE_X) {
-                game->world.chunks[world_get_chunk_index(chunk_coord[0] + 1, chunk_coord[1], chunk_coord[2])].dirty = true;
-            }
-            if(local_coord[1] == 0 && chunk_coord[0] > 0) { // y
-                game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1] - 1, chunk_coord[2])].dirty = true;
-            } else if(local_coord[1] == CHUNK_SIZE - 1 && chunk_coord[0] < WORLD_SIZE_X) {
-                game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1] + 1, chunk_coord[2])].dirty = true;
-            }
-            if(local_coord[2] == 0 && chunk_coord[0] > 0) { // z
-                game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1], chunk_coord[2] - 1)].dirty = true;
-            } else if(local_coord[2] == CHUNK_SIZE - 1 && chunk_coord[0] < WORLD_SIZE_X) {
-                game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1], chunk_coord[2] + 1)].dirty = true;
-            }
-
-            game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1], chunk_coord[2])].dirty = true;
+					hit_coord[0], hit_coord[1], hit_coord[2], selected_block); // marks the touched sections dirty
 		}
 	}
 }
@@ -246,37 +210,6 @@ void player_destroy_block(Game* game) {
 		if(world_get_block(&game->world, hit_coord[0], hit_coord[1], hit_coord[2]) != block) {
 
 			world_set_block(&game->world, hit_coord[0], hit_coord[1], hit_coord[2], block);
-
-            ivec3 chunk_coord = {
-                hit_coord[0] / CHUNK_SIZE,
-                hit_coord[1] / CHUNK_SIZE,
-                hit_coord[2] / CHUNK_SIZE
-            };
-
-            ivec3 local_coord = {
-                hit_coord[0] % CHUNK_SIZE,
-                hit_coord[1] % CHUNK_SIZE,
-                hit_coord[2] % CHUNK_SIZE
-            };
-			
-            // check neighbors
-            if(local_coord[0] == 0 && chunk_coord[0] > 0) { // x
-                game->world.chunks[world_get_chunk_index(chunk_coord[0] - 1, chunk_coord[1], chunk_coord[2])].dirty = true;
-            } else if(local_coord[0] == CHUNK_SIZE - 1 && chunk_coord[0] < WORLD_SIZE_X) {
-                game->world.chunks[world_get_chunk_index(chunk_coord[0] + 1, chunk_coord[1], chunk_coord[2])].dirty = true;
-            }
-            if(local_coord[1] == 0 && chunk_coord[0] > 0) { // y
-                game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1] - 1, chunk_coord[2])].dirty = true;
-            } else if(local_coord[1] == CHUNK_SIZE - 1 && chunk_coord[0] < WORLD_SIZE_X) {
-                game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1] + 1, chunk_coord[2])].dirty = true;
-            }
-            if(local_coord[2] == 0 && chunk_coord[0] > 0) { // z
-                game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1], chunk_coord[2] - 1)].dirty = true;
-            } else if(local_coord[2] == CHUNK_SIZE - 1 && chunk_coord[0] < WORLD_SIZE_X) {
-                game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1], chunk_coord[2] + 1)].dirty = true;
-            }
-
-            game->world.chunks[world_get_chunk_index(chunk_coord[0], chunk_coord[1], chunk_coord[2])].dirty = true;
 		}
 	}
 	fflush(stdout);
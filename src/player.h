@@ -19,7 +19,7 @@ typedef struct {
     Inventory inventory;
 } Player;
 
-void player_init(Player* player);
+void player_init(Player* player, vec3 spawn_position);
 void player_update(Player* player, Game* game); // view update not physics
 // void player_unload(Player* player);
 
@@ -0,0 +1,458 @@
+#include "region.h"
+#include "chunk.h"
+#include "chunk_codec.h"
+#include "filepath.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define REGION_CHUNK_HEADER 8  // payload length, codec, three reserved bytes
+#define REGION_CODEC_RAW 0     // every block type, then every light level, a byte each
+#define REGION_CODEC_PALETTE 1 // chunk_codec.h, what new chunks are written with
+#define REGION_RAW_SIZE (MAX_CHUNK_SIZE * 2)
+
+#ifdef CCRAFT_CHUNK_LZ
+#define REGION_COMPRESS true
+#else
+#define REGION_COMPRESS false
+#endif
+
+static void region_put_u32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t region_get_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+// pushes what was written so far to the disk itself, not just the os
+static bool region_sync(RegionFile* region) {
+    if (fflush(region->file) != 0) return false;
+#if defined(_WIN32)
+    return _commit(_fileno(region->file)) == 0;
+#else
+    return fsync(fileno(region->file)) == 0;
+#endif
+}
+
+static void region_unmap(RegionFile* region) {
+    if (!region->map) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(region->map);
+    CloseHandle(region->map_handle);
+    region->map_handle = NULL;
+#else
+    munmap((void*)region->map, region->map_size);
+#endif
+    region->map = NULL;
+    region->map_size = 0;
+}
+
+// maps the file as it is on disk now, writes through the FILE stay visible
+// in the view since both share the page cache
+static bool region_map(RegionFile* region) {
+    region_unmap(region);
+    if (fflush(region->file) != 0 || fseek(region->file, 0, SEEK_END) != 0) return false;
+    long length = ftell(region->file);
+    if (length <= 0) return false;
+
+#if defined(_WIN32)
+    HANDLE file = (HANDLE)_get_osfhandle(_fileno(region->file));
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return false;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    region->map_handle = mapping;
+#else
+    void* view = mmap(NULL, (size_t)length, PROT_READ, MAP_SHARED, fileno(region->file), 0);
+    if (view == MAP_FAILED) return false;
+    // chunks are read out of order, readahead would mostly fetch neighbors nobody asked for
+    madvise(view, (size_t)length, MADV_RANDOM);
+#endif
+    region->map = view;
+    region->map_size = (size_t)length;
+    return true;
+}
+
+static bool region_grow(RegionFile* region, uint32_t sector_count) {
+    if (sector_count <= region->sector_count) return true;
+    uint8_t* used = realloc(region->used, sector_count);
+    if (!used) {
+        fprintf(stderr, "REGION: failed to grow sector map\n");
+        return false;
+    }
+    memset(used + region->sector_count, 0, sector_count - region->sector_count);
+    region->used = used;
+    region->sector_count = sector_count;
+    return true;
+}
+
+static bool region_write_header(RegionFile* region) {
+    uint8_t* header = calloc(REGION_HEADER_SECTORS, REGION_SECTOR_SIZE);
+    if (!header) return false;
+
+    region_put_u32(header, REGION_MAGIC);
+    region_put_u32(header + 4, REGION_VERSION);
+    bool ok = fseek(region->file, 0, SEEK_SET) == 0 &&
+              fwrite(header, REGION_SECTOR_SIZE, REGION_HEADER_SECTORS, region->file) == REGION_HEADER_SECTORS;
+    free(header);
+    return ok && fflush(region->file) == 0;
+}
+
+static bool region_read_header(RegionFile* region) {
+    uint8_t header[8];
+    if (fseek(region->file, 0, SEEK_SET) != 0 || fread(header, 1, sizeof(header), region->file) != sizeof(header)) return false;
+    if (region_get_u32(header) != REGION_MAGIC || region_get_u32(header + 4) != REGION_VERSION) return false;
+
+    uint8_t* table = malloc(REGION_CHUNK_COUNT * 4);
+    if (!table) return false;
+    bool ok = fseek(region->file, REGION_SECTOR_SIZE, SEEK_SET) == 0 &&
+              fread(table, 4, REGION_CHUNK_COUNT, region->file) == REGION_CHUNK_COUNT;
+    for (int i = 0; ok && i < REGION_CHUNK_COUNT; i++) {
+        region->offsets[i] = region_get_u32(table + i * 4);
+    }
+    free(table);
+    return ok;
+}
+
+RegionFile* region_open(const char* path, int region_x, int region_z, bool create) {
+    FILE* file = fopen(path, "r+b");
+    bool created = false;
+    if (!file) {
+        if (!create) return NULL;
+        file = fopen(path, "w+b");
+        created = true;
+    }
+    if (!file) {
+        fprintf(stderr, "REGION: failed to open %s\n", path);
+        return NULL;
+    }
+
+    RegionFile* region = calloc(1, sizeof(RegionFile));
+    if (!region) {
+        fclose(file);
+        return NULL;
+    }
+    region->file = file;
+    region->region_x = region_x;
+    region->region_z = region_z;
+
+    // a file cut short before its header was complete starts over as a new one
+    if (!created && !region_read_header(region)) {
+        fprintf(stderr, "REGION: %s has a short or invalid header, reinitialising it\n", path);
+        memset(region->offsets, 0, sizeof(region->offsets));
+        created = true;
+    }
+    if (created && !region_write_header(region)) {
+        fprintf(stderr, "REGION: failed to write header of %s\n", path);
+        region_close(region);
+        return NULL;
+    }
+
+    // a torn append can leave a partial last sector, it counts as allocated
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    uint32_t sectors = (uint32_t)((length + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE);
+    if (sectors < REGION_HEADER_SECTORS) sectors = REGION_HEADER_SECTORS;
+    if (!region_grow(region, sectors)) {
+        region_close(region);
+        return NULL;
+    }
+    memset(region->used, 1, REGION_HEADER_SECTORS);
+
+    // drop entries pointing outside the file or into sectors already claimed
+    for (int i = 0; i < REGION_CHUNK_COUNT; i++) {
+        uint32_t offset = region->offsets[i];
+        if (!offset) continue;
+
+        uint32_t first = offset >> 8, count = offset & 0xff;
+        bool valid = count > 0 && first >= REGION_HEADER_SECTORS && first + count <= region->sector_count;
+        for (uint32_t s = first; valid && s < first + count; s++) {
+            if (region->used[s]) valid = false;
+        }
+        if (!valid) {
+            fprintf(stderr, "REGION: dropping corrupt entry %d in %s\n", i, path);
+            region->offsets[i] = 0;
+            continue;
+        }
+        memset(region->used + first, 1, count);
+    }
+
+    if (!region_map(region)) fprintf(stderr, "REGION: could not map %s, reading through the file\n", path);
+    return region;
+}
+
+void region_close(RegionFile* region) {
+    if (!region) return;
+    region_commit(region);
+    region_unmap(region);
+    if (region->file) fclose(region->file);
+    free(region->used);
+    free(region);
+}
+
+bool region_has_chunk(const RegionFile* region, int index) {
+    return index >= 0 && index < REGION_CHUNK_COUNT && region->offsets[index] != 0;
+}
+
+// data holds the chunk's sectors, capacity bytes of them
+static bool region_decode_chunk(const uint8_t* data, size_t capacity, int index, Block* blocks) {
+    uint32_t length = region_get_u32(data);
+    uint8_t codec = data[4];
+    if (length > capacity - REGION_CHUNK_HEADER) {
+        fprintf(stderr, "REGION: chunk %d is longer than its sectors\n", index);
+        return false;
+    }
+
+    if (codec == REGION_CODEC_PALETTE) {
+        if (chunk_codec_decode(data + REGION_CHUNK_HEADER, length, blocks)) return true;
+        fprintf(stderr, "REGION: chunk %d failed to decode\n", index);
+        return false;
+    }
+    if (codec != REGION_CODEC_RAW || length != REGION_RAW_SIZE) {
+        fprintf(stderr, "REGION: chunk %d has an unknown layout\n", index);
+        return false;
+    }
+
+    const uint8_t* types = data + REGION_CHUNK_HEADER;
+    const uint8_t* lights = types + MAX_CHUNK_SIZE;
+    for (int i = 0; i < MAX_CHUNK_SIZE; i++) {
+        blocks[i].type = types[i] < BLOCK_TYPE_COUNT ? (BlockType)types[i] : BLOCK_AIR;
+        blocks[i].light_level = lights[i] & 15;
+    }
+    return true;
+}
+
+bool region_read_chunk(RegionFile* region, int index, Block* blocks) {
+    if (!region_has_chunk(region, index)) return false;
+
+    uint32_t first = region->offsets[index] >> 8, count = region->offsets[index] & 0xff;
+    size_t begin = (size_t)first * REGION_SECTOR_SIZE;
+    size_t capacity = (size_t)count * REGION_SECTOR_SIZE;
+
+    // the file may have grown since it was mapped
+    if (region->map && begin + capacity > region->map_size) region_map(region);
+    if (region->map && begin + capacity <= region->map_size) {
+        return region_decode_chunk(region->map + begin, capacity, index, blocks);
+    }
+
+    uint8_t* data = malloc(capacity);
+    if (!data) return false;
+    bool ok = fseek(region->file, (long)begin, SEEK_SET) == 0 &&
+              fread(data, 1, capacity, region->file) == capacity &&
+              region_decode_chunk(data, capacity, index, blocks);
+    free(data);
+    return ok;
+}
+
+void region_prefetch_chunk(RegionFile* region, int index) {
+    if (!region_has_chunk(region, index) || !region->map) return;
+
+    size_t begin = (size_t)(region->offsets[index] >> 8) * REGION_SECTOR_SIZE;
+    size_t end = begin + (size_t)(region->offsets[index] & 0xff) * REGION_SECTOR_SIZE;
+    if (end > region->map_size) end = region->map_size;
+    if (begin >= end) return;
+
+#if defined(_WIN32)
+#if _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY range = { (PVOID)(region->map + begin), end - begin };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+    // madvise wants a page aligned start, pages may be larger than a sector
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t aligned = begin - begin % page;
+    madvise((void*)(region->map + aligned), end - aligned, MADV_WILLNEED);
+#endif
+}
+
+// first run of count free sectors, or the end of the file
+static uint32_t region_find_sectors(const RegionFile* region, uint32_t count) {
+    uint32_t run = 0;
+    for (uint32_t s = REGION_HEADER_SECTORS; s < region->sector_count; s++) {
+        run = region->used[s] ? 0 : run + 1;
+        if (run == count) return s + 1 - count;
+    }
+    return region->sector_count - run; // a free tail can be extended
+}
+
+// sectors of an entry that no longer back anything on disk
+static void region_release(RegionFile* region, uint32_t offset) {
+    if (offset & 0xff) memset(region->used + (offset >> 8), 0, offset & 0xff);
+}
+
+bool region_stage_chunk(RegionFile* region, int index, const Block* blocks) {
+    if (index < 0 || index >= REGION_CHUNK_COUNT) return false;
+    if (region->pending_count == REGION_MAX_PENDING && !region_commit(region)) return false;
+
+    // sized for the worst case, then padded to whole sectors so the file stays aligned
+    size_t capacity = REGION_CHUNK_HEADER + CHUNK_CODEC_MAX_SIZE;
+    capacity = (capacity + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE * REGION_SECTOR_SIZE;
+    uint8_t* data = calloc(1, capacity);
+    if (!data) return false;
+
+    size_t length = chunk_codec_encode(blocks, data + REGION_CHUNK_HEADER, capacity - REGION_CHUNK_HEADER, REGION_COMPRESS);
+    if (!length) {
+        fprintf(stderr, "REGION: failed to encode chunk %d\n", index);
+        free(data);
+        return false;
+    }
+    region_put_u32(data, (uint32_t)length);
+    data[4] = REGION_CODEC_PALETTE;
+    uint32_t count = (uint32_t)((REGION_CHUNK_HEADER + length + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE);
+
+    // always into free sectors, the old copy stays intact and still used until
+    // the table points elsewhere, so a crash leaves one of the two readable
+    uint32_t first = region_find_sectors(region, count);
+    if (!region_grow(region, first + count)) {
+        free(data);
+        return false;
+    }
+
+    bool ok = fseek(region->file, (long)first * REGION_SECTOR_SIZE, SEEK_SET) == 0 &&
+              fwrite(data, REGION_SECTOR_SIZE, count, region->file) == count;
+    free(data);
+    if (!ok) {
+        fprintf(stderr, "REGION: failed to write chunk %d\n", index);
+        return false;
+    }
+    memset(region->used + first, 1, count);
+
+    // staged twice before a commit, only the newer copy is kept
+    int slot = 0;
+    while (slot < region->pending_count && region->pending_index[slot] != index) slot++;
+    if (slot < region->pending_count) region_release(region, region->pending_offset[slot]);
+    else region->pending_count++;
+    region->pending_index[slot] = index;
+    region->pending_offset[slot] = first << 8 | count;
+    return true;
+}
+
+bool region_commit(RegionFile* region) {
+    int pending = region->pending_count;
+    if (pending == 0) return true;
+    region->pending_count = 0;
+
+    // one sync for every staged chunk, nothing on disk points at them yet
+    if (!region_sync(region)) {
+        fprintf(stderr, "REGION: failed to sync %d staged chunks\n", pending);
+        for (int p = 0; p < pending; p++) {
+            region_release(region, region->pending_offset[p]);
+        }
+        return false;
+    }
+
+    // the entries only change once the data is on disk
+    bool ok = true;
+    for (int p = 0; ok && p < pending; p++) {
+        uint8_t entry[4];
+        region_put_u32(entry, region->pending_offset[p]);
+        ok = fseek(region->file, REGION_SECTOR_SIZE + (long)region->pending_index[p] * 4, SEEK_SET) == 0 &&
+             fwrite(entry, 1, 4, region->file) == 4;
+    }
+    if (!ok || fflush(region->file) != 0) {
+        // the table on disk may name the old or the new sectors, keep both
+        fprintf(stderr, "REGION: failed to update the offsets of %d chunks\n", pending);
+        return false;
+    }
+
+    for (int p = 0; p < pending; p++) {
+        int index = region->pending_index[p];
+        region_release(region, region->offsets[index]);
+        region->offsets[index] = region->pending_offset[p];
+    }
+    return true;
+}
+
+bool region_write_chunk(RegionFile* region, int index, const Block* blocks) {
+    return region_stage_chunk(region, index, blocks) && region_commit(region);
+}
+
+void region_store_init(RegionStore* store, const char* directory) {
+    memset(store, 0, sizeof(*store));
+    strncpy(store->directory, directory, sizeof(store->directory) - 1);
+    path_make_directory(store->directory);
+}
+
+void region_store_free(RegionStore* store) {
+    for (int i = 0; i < REGION_CACHE_SIZE; i++) {
+        region_close(store->regions[i]);
+        store->regions[i] = NULL;
+    }
+}
+
+static RegionFile* region_store_get(RegionStore* store, int region_x, int region_z, bool create) {
+    int slot = 0;
+    for (int i = 0; i < REGION_CACHE_SIZE; i++) {
+        RegionFile* region = store->regions[i];
+        if (region && region->region_x == region_x && region->region_z == region_z) {
+            store->last_used[i] = ++store->clock;
+            return region;
+        }
+        // empty slots first, then the least recently used
+        if (!store->regions[slot]) continue;
+        if (!region || store->last_used[i] < store->last_used[slot]) slot = i;
+    }
+
+    char path[1100];
+    snprintf(path, sizeof(path), "%s/r.%d.%d.bin", store->directory, region_x, region_z);
+    RegionFile* region = region_open(path, region_x, region_z, create);
+    if (!region) return NULL;
+
+    region_close(store->regions[slot]);
+    store->regions[slot] = region;
+    store->last_used[slot] = ++store->clock;
+    return region;
+}
+
+static int region_chunk_slot(int cx, int cy, int cz) {
+    int local_x = cx - region_floor_div(cx) * REGION_SIZE;
+    int local_z = cz - region_floor_div(cz) * REGION_SIZE;
+    return (local_x * REGION_SIZE + local_z) * REGION_CHUNKS_Y + cy;
+}
+
+bool region_store_read_chunk(RegionStore* store, int cx, int cy, int cz, Block* blocks) {
+    if (cy < 0 || cy >= REGION_CHUNKS_Y) return false;
+    RegionFile* region = region_store_get(store, region_floor_div(cx), region_floor_div(cz), false);
+    return region && region_read_chunk(region, region_chunk_slot(cx, cy, cz), blocks);
+}
+
+void region_store_prefetch_chunk(RegionStore* store, int cx, int cy, int cz) {
+    if (cy < 0 || cy >= REGION_CHUNKS_Y) return;
+    RegionFile* region = region_store_get(store, region_floor_div(cx), region_floor_div(cz), false);
+    if (region) region_prefetch_chunk(region, region_chunk_slot(cx, cy, cz));
+}
+
+bool region_store_write_chunk(RegionStore* store, int cx, int cy, int cz, const Block* blocks) {
+    if (cy < 0 || cy >= REGION_CHUNKS_Y) return false;
+    RegionFile* region = region_store_get(store, region_floor_div(cx), region_floor_div(cz), true);
+    return region && region_write_chunk(region, region_chunk_slot(cx, cy, cz), blocks);
+}
+
+bool region_store_stage_chunk(RegionStore* store, int cx, int cy, int cz, const Block* blocks) {
+    if (cy < 0 || cy >= REGION_CHUNKS_Y) return false;
+    RegionFile* region = region_store_get(store, region_floor_div(cx), region_floor_div(cz), true);
+    return region && region_stage_chunk(region, region_chunk_slot(cx, cy, cz), blocks);
+}
+
+bool region_store_commit(RegionStore* store) {
+    bool ok = true;
+    for (int i = 0; i < REGION_CACHE_SIZE; i++) {
+        if (store->regions[i] && !region_commit(store->regions[i])) ok = false;
+    }
+    return ok;
+}
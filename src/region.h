@@ -0,0 +1,80 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "block.h"
+
+// a region file holds REGION_SIZE x REGION_SIZE chunk columns, each
+// REGION_CHUNKS_Y chunks tall; chunks live in 4096 byte sectors found through
+// an offset table at the start of the file
+#define REGION_SIZE 32
+#define REGION_CHUNKS_Y 16
+#define REGION_CHUNK_COUNT (REGION_SIZE * REGION_SIZE * REGION_CHUNKS_Y)
+#define REGION_SECTOR_SIZE 4096
+#define REGION_MAGIC 0x47525243u // "CRRG"
+#define REGION_VERSION 1
+#define REGION_CACHE_SIZE 8 // region files kept open at once
+#define REGION_MAX_PENDING 64 // staged chunks per file before a commit is forced
+
+// sector 0 is the file header, the offset table follows it
+#define REGION_TABLE_SECTORS ((REGION_CHUNK_COUNT * 4 + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE)
+#define REGION_HEADER_SECTORS (1 + REGION_TABLE_SECTORS)
+
+typedef struct {
+    FILE* file;
+    int region_x;
+    int region_z;
+    uint32_t offsets[REGION_CHUNK_COUNT]; // first sector << 8 | sector count, 0 when absent
+    uint8_t* used;         // one entry per sector of the file
+    uint32_t sector_count; // file length in sectors
+
+    const uint8_t* map; // read-only view of the whole file, chunks decode straight from it
+    size_t map_size;    // remapped when a chunk lies past it, NULL map falls back to fread
+    void* map_handle;   // file mapping object on windows
+
+    // chunks written to free sectors whose table entries wait for region_commit
+    int pending_index[REGION_MAX_PENDING];
+    uint32_t pending_offset[REGION_MAX_PENDING];
+    int pending_count;
+} RegionFile;
+
+RegionFile* region_open(const char* path, int region_x, int region_z, bool create); // NULL if missing, a bad header starts a new file
+void region_close(RegionFile* region);
+
+// index is the chunk's slot within the region, (x * REGION_SIZE + z) * REGION_CHUNKS_Y + y
+bool region_has_chunk(const RegionFile* region, int index);
+bool region_read_chunk(RegionFile* region, int index, Block* blocks);
+// staging writes the chunk into free sectors, commit syncs the file once and then
+// points the table at everything staged; reads see the old copy until then
+bool region_stage_chunk(RegionFile* region, int index, const Block* blocks);
+bool region_commit(RegionFile* region); // false drops what was staged
+bool region_write_chunk(RegionFile* region, int index, const Block* blocks); // stage and commit, never overwrites the copy on disk
+void region_prefetch_chunk(RegionFile* region, int index); // start paging the chunk in, returns at once
+
+// region coordinate of a chunk coordinate, rounding down for negative ones
+static inline int region_floor_div(int chunk_coord) {
+    return chunk_coord >= 0 ? chunk_coord / REGION_SIZE : -((-chunk_coord + REGION_SIZE - 1) / REGION_SIZE);
+}
+
+// the open region files of one world directory
+typedef struct {
+    char directory[1024];
+    RegionFile* regions[REGION_CACHE_SIZE];
+    uint32_t last_used[REGION_CACHE_SIZE];
+    uint32_t clock;
+} RegionStore;
+
+void region_store_init(RegionStore* store, const char* directory);
+void region_store_free(RegionStore* store);
+
+// chunk coordinates, false when the chunk was never saved or cy is out of range
+bool region_store_read_chunk(RegionStore* store, int cx, int cy, int cz, Block* blocks);
+bool region_store_write_chunk(RegionStore* store, int cx, int cy, int cz, const Block* blocks);
+bool region_store_stage_chunk(RegionStore* store, int cx, int cy, int cz, const Block* blocks);
+bool region_store_commit(RegionStore* store); // every open file, false if any failed
+void region_store_prefetch_chunk(RegionStore* store, int cx, int cy, int cz);
+
+#endif // REGION_H
@@ -8,6 +8,7 @@ typedef struct {
 	Frustum frustum;
     mat4 projection;
     mat4 view;
+    vec3 camera_position;
 } RenderContext;
 
 #endif
@@ -0,0 +1,144 @@
+#include "resource_loader.h"
+
+#include <stb_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void request_free(ResourceRequest* request) {
+    if (request->pixels) stbi_image_free(request->pixels);
+    free(request->path);
+    free(request);
+}
+
+static void loader_worker(void* arg) {
+    ResourceLoader* loader = arg;
+    stbi_set_flip_vertically_on_load_thread(1);
+
+    mutex_lock(&loader->mutex);
+    while (true) {
+        while (loader->running && !loader->pending) {
+            cond_wait(&loader->cond, &loader->mutex);
+        }
+        if (!loader->running) break;
+
+        ResourceRequest* request = loader->pending;
+        loader->pending = request->next;
+        if (!loader->pending) loader->pending_tail = NULL;
+        mutex_unlock(&loader->mutex);
+
+        int channels;
+        request->pixels = stbi_load(request->path, &request->width, &request->height, &channels, 4);
+        if (!request->pixels) {
+            fprintf(stderr, "TEXTURE: Failed to load texture at path: %s\n", request->path);
+        }
+
+        mutex_lock(&loader->mutex);
+        request->next = NULL;
+        if (loader->decoded_tail) loader->decoded_tail->next = request;
+        else loader->decoded = request;
+        loader->decoded_tail = request;
+    }
+    mutex_unlock(&loader->mutex);
+}
+
+void resource_loader_init(ResourceLoader* loader) {
+    memset(loader, 0, sizeof(*loader));
+    mutex_init(&loader->mutex);
+    cond_init(&loader->cond);
+    loader->running = true;
+
+    if (!thread_create(&loader->thread, loader_worker, loader)) {
+        loader->running = false;
+    }
+}
+
+void resource_loader_free(ResourceLoader* loader) {
+    bool started = loader->running;
+
+    mutex_lock(&loader->mutex);
+    loader->running = false;
+    cond_signal(&loader->cond);
+    mutex_unlock(&loader->mutex);
+    if (started) thread_join(&loader->thread);
+
+    for (ResourceRequest* request = loader->pending; request;) {
+        ResourceRequest* next = request->next;
+        request_free(request);
+        request = next;
+    }
+    for (ResourceRequest* request = loader->decoded; request;) {
+        ResourceRequest* next = request->next;
+        request_free(request);
+        request = next;
+    }
+
+    cond_destroy(&loader->cond);
+    mutex_destroy(&loader->mutex);
+    memset(loader, 0, sizeof(*loader));
+}
+
+void resource_loader_load_texture_array(ResourceLoader* loader, Texture* texture, const char* path, int tiles_x, int tiles_y) {
+    texture->texture_type = GL_TEXTURE_2D_ARRAY;
+    texture->file_path = path;
+    glGenTextures(1, &texture->ID);
+
+    ResourceRequest* request = calloc(1, sizeof(ResourceRequest));
+    if (!request) {
+        fprintf(stderr, "RESOURCE: failed to allocate request\n");
+        return;
+    }
+    request->texture = texture;
+    request->path = strdup(path);
+    request->tiles_x = tiles_x;
+    request->tiles_y = tiles_y;
+
+    // without a worker the image is decoded by the next poll instead
+    mutex_lock(&loader->mutex);
+    if (loader->pending_tail) loader->pending_tail->next = request;
+    else loader->pending = request;
+    loader->pending_tail = request;
+    loader->in_flight++;
+    cond_signal(&loader->cond);
+    mutex_unlock(&loader->mutex);
+}
+
+int resource_loader_poll(ResourceLoader* loader) {
+    mutex_lock(&loader->mutex);
+    // no worker thread, decode here
+    if (!loader->running) {
+        for (ResourceRequest* request = loader->pending; request; request = request->next) {
+            int channels;
+            stbi_set_flip_vertically_on_load(1);
+            request->pixels = stbi_load(request->path, &request->width, &request->height, &channels, 4);
+        }
+        if (loader->pending) {
+            if (loader->decoded_tail) loader->decoded_tail->next = loader->pending;
+            else loader->decoded = loader->pending;
+            loader->decoded_tail = loader->pending_tail;
+            loader->pending = loader->pending_tail = NULL;
+        }
+    }
+
+    ResourceRequest* decoded = loader->decoded;
+    loader->decoded = loader->decoded_tail = NULL;
+    mutex_unlock(&loader->mutex);
+
+    int finished = 0;
+    while (decoded) {
+        ResourceRequest* next = decoded->next;
+        if (decoded->pixels) {
+            texture_upload_array(decoded->texture, decoded->pixels, decoded->width, decoded->height,
+                decoded->tiles_x, decoded->tiles_y);
+        }
+        request_free(decoded);
+        decoded = next;
+        finished++;
+    }
+
+    mutex_lock(&loader->mutex);
+    loader->in_flight -= finished;
+    int in_flight = loader->in_flight;
+    mutex_unlock(&loader->mutex);
+    return in_flight;
+}
@@ -0,0 +1,46 @@
+#ifndef RESOURCE_LOADER_H
+#define RESOURCE_LOADER_H
+
+#include <stdbool.h>
+
+#include "texture.h"
+#include "thread.h"
+
+typedef struct ResourceRequest {
+    Texture* texture;
+    char* path;
+    int tiles_x;
+    int tiles_y;
+
+    unsigned char* pixels; // set by the worker, NULL if decoding failed
+    int width;
+    int height;
+
+    struct ResourceRequest* next;
+} ResourceRequest;
+
+// decodes images on a worker thread, resource_loader_poll uploads the results
+// on the thread that owns the GL context
+typedef struct {
+    Thread thread;
+    Mutex mutex;
+    CondVar cond;
+
+    ResourceRequest* pending;      // waiting for the worker, oldest first
+    ResourceRequest* pending_tail;
+    ResourceRequest* decoded;      // waiting for upload
+    ResourceRequest* decoded_tail;
+    int in_flight;
+    bool running;
+} ResourceLoader;
+
+void resource_loader_init(ResourceLoader* loader);
+void resource_loader_free(ResourceLoader* loader); // drops unfinished requests
+
+// texture gets its name now and its pixels during a later poll
+void resource_loader_load_texture_array(ResourceLoader* loader, Texture* texture, const char* path, int tiles_x, int tiles_y);
+
+// uploads finished decodes, returns the number of requests still in flight
+int resource_loader_poll(ResourceLoader* loader);
+
+#endif // RESOURCE_LOADER_H
@@ -1,7 +1,12 @@
 #include "shader.h"
+#include "filepath.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+#define SHADER_CACHE_DIR "cache/shaders"
+#define SHADER_CACHE_MAGIC 0x42534343u // "CCSB"
 
 static char* read_file(const char* path) {
 	FILE* file = fopen(path, "rb");
@@ -44,16 +49,135 @@ static void check_compile_errors(unsigned int shader, const char* type, const ch
 	}
 }
 
+static uint64_t fnv1a(uint64_t hash, const char* data) {
+	if(!data) return hash;
+	for(const unsigned char* c = (const unsigned char*)data; *c; c++) {
+		hash ^= *c;
+		hash *= 0x100000001b3ull;
+	}
+	hash ^= 0xff; // separator, so "ab" + "c" differs from "a" + "bc"
+	hash *= 0x100000001b3ull;
+	return hash;
+}
+
+// binaries are only valid for the same sources on the same driver
+static bool shader_cache_path(char* out_path, const char* vertex_code, const char* fragment_code) {
+	GLint formats = 0;
+	if(!GLAD_GL_ARB_get_program_binary) return false;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if(formats <= 0) return false;
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	hash = fnv1a(hash, vertex_code);
+	hash = fnv1a(hash, fragment_code);
+	hash = fnv1a(hash, (const char*)glGetString(GL_VENDOR));
+	hash = fnv1a(hash, (const char*)glGetString(GL_RENDERER));
+	hash = fnv1a(hash, (const char*)glGetString(GL_VERSION));
+
+	char relative[64];
+	snprintf(relative, sizeof(relative), SHADER_CACHE_DIR "/%016llx.bin", (unsigned long long)hash);
+	return path_make_absolute(out_path, relative) == 0;
+}
+
+// returns a linked program, or 0 if there is no usable binary
+static unsigned int shader_cache_load(const char* cache_path) {
+	FILE* file = fopen(cache_path, "rb");
+	if(!file) return 0;
+
+	uint32_t header[3]; // magic, format, length
+	if(fread(header, sizeof(header), 1, file) != 1 || header[0] != SHADER_CACHE_MAGIC) {
+		fclose(file);
+		return 0;
+	}
+
+	void* binary = malloc(header[2]);
+	if(!binary || fread(binary, 1, header[2], file) != header[2]) {
+		free(binary);
+		fclose(file);
+		return 0;
+	}
+	fclose(file);
+
+	unsigned int program = glCreateProgram();
+	glProgramBinary(program, header[1], binary, (GLsizei)header[2]);
+	free(binary);
+
+	// drivers reject binaries after updates, the caller recompiles
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if(!success) {
+		fprintf(stderr, "SHADER: cached binary rejected, compiling %s\n", cache_path);
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+static void shader_cache_store(const char* cache_path, unsigned int program) {
+	int success, length = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(!success || length <= 0) return;
+
+	void* binary = malloc(length);
+	if(!binary) return;
+
+	GLenum format;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &format, binary);
+
+	char* directory = make_path(SHADER_CACHE_DIR);
+	if(directory) path_make_directory(directory);
+	free(directory);
+
+	// written next to the cache file and renamed over it, a crash or a full
+	// disk never leaves a truncated binary behind
+	char temp_path[1100];
+	snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache_path);
+	FILE* file = fopen(temp_path, "wb");
+	if(!file) {
+		fprintf(stderr, "SHADER: failed to write cache %s\n", cache_path);
+		free(binary);
+		return;
+	}
+	uint32_t header[3] = { SHADER_CACHE_MAGIC, (uint32_t)format, (uint32_t)written };
+	bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+	          fwrite(binary, 1, written, file) == (size_t)written;
+	ok = fclose(file) == 0 && ok;
+	free(binary);
+
+#if defined(_WIN32)
+	if(ok) remove(cache_path); // rename does not replace on windows
+#endif
+	if(!ok || rename(temp_path, cache_path) != 0) {
+		fprintf(stderr, "SHADER: failed to write cache %s\n", cache_path);
+		remove(temp_path);
+	}
+}
+
 Shader shader_create(const char* vertex_path, const char* fragment_path) {
 	Shader shader;
 	char* vertex_code = read_file(vertex_path);
 	char* fragment_code = read_file(fragment_path);
 
 	if(!vertex_code || !fragment_code) {
+		free(vertex_code);
+		free(fragment_code);
 		shader.ID = 0;
 		return shader;
 	}
 
+	char cache_path[1024];
+	bool cacheable = shader_cache_path(cache_path, vertex_code, fragment_code);
+	if(cacheable) {
+		shader.ID = shader_cache_load(cache_path);
+		if(shader.ID) {
+			free(vertex_code);
+			free(fragment_code);
+			return shader;
+		}
+	}
+
 	unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertex, 1, (const char**)&vertex_code, NULL);
 	glCompileShader(vertex);
@@ -65,10 +189,12 @@ Shader shader_create(const char* vertex_path, const char* fragment_path) {
 	check_compile_errors(fragment, "FRAGMENT", fragment_path);
 
 	shader.ID = glCreateProgram();
+	if(cacheable) glProgramParameteri(shader.ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glAttachShader(shader.ID, vertex);
 	glAttachShader(shader.ID, fragment);
 	glLinkProgram(shader.ID);
 	check_compile_errors(shader.ID, "PROGRAM", "shader_program");
+	if(cacheable) shader_cache_store(cache_path, shader.ID);
 
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
@@ -0,0 +1,147 @@
+#include "terrain.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void terrain_init(TerrainGenerator* terrain, uint64_t seed, int columns_x, int columns_z) {
+    noise_context_init(&terrain->noise, seed);
+    terrain->columns_x = columns_x;
+    terrain->columns_z = columns_z;
+    terrain->columns = calloc((size_t)columns_x * columns_z, sizeof(TerrainColumn));
+    if (!terrain->columns) {
+        fprintf(stderr, "TERRAIN: failed to allocate height cache\n");
+        terrain->columns_x = terrain->columns_z = 0;
+    }
+    for (int i = 0; i < terrain->columns_x * terrain->columns_z; i++) {
+        mutex_init(&terrain->columns[i].mutex);
+    }
+}
+
+void terrain_free(TerrainGenerator* terrain) {
+    for (int i = 0; i < terrain->columns_x * terrain->columns_z; i++) {
+        mutex_destroy(&terrain->columns[i].mutex);
+    }
+    free(terrain->columns);
+    terrain->columns = NULL;
+    terrain->columns_x = terrain->columns_z = 0;
+}
+
+static void terrain_build_column(TerrainGenerator* terrain, TerrainColumn* column, int cx, int cz) {
+    float noise[CHUNK_SIZE * CHUNK_SIZE];
+    noise_fbm_grid_2d(&terrain->noise, cx * CHUNK_SIZE, cz * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE,
+                      TERRAIN_FREQUENCY, 0.0f, TERRAIN_OCTAVES, noise);
+
+    column->max_height = 0;
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            int height = TERRAIN_BASE_HEIGHT + (int)(noise[x * CHUNK_SIZE + z] * TERRAIN_HEIGHT_RANGE);
+            if (height < 1) height = 1;
+
+            column->heights[x * CHUNK_SIZE + z] = (int16_t)height;
+            if (height > column->max_height) column->max_height = (int16_t)height;
+        }
+    }
+    atomic_store_release(&column->cached, 1); // heights are visible before the flag
+}
+
+const TerrainColumn* terrain_get_column(TerrainGenerator* terrain, int cx, int cz) {
+    if (cx < 0 || cz < 0 || cx >= terrain->columns_x || cz >= terrain->columns_z) return NULL;
+
+    // generator threads share the cache, the first one to need a column builds
+    // it while others wanting the same column wait; built columns take no lock
+    TerrainColumn* column = &terrain->columns[cx * terrain->columns_z + cz];
+    if (atomic_load_acquire(&column->cached)) return column;
+
+    mutex_lock(&column->mutex);
+    if (!column->cached) terrain_build_column(terrain, column, cx, cz);
+    mutex_unlock(&column->mutex);
+    return column;
+}
+
+int terrain_get_height(TerrainGenerator* terrain, int x, int z) {
+    const TerrainColumn* column = terrain_get_column(terrain, x / CHUNK_SIZE, z / CHUNK_SIZE);
+    if (!column) return 0;
+    return column->heights[(x % CHUNK_SIZE) * CHUNK_SIZE + z % CHUNK_SIZE];
+}
+
+void terrain_fill(TerrainGenerator* terrain, Block* blocks, int cx, int cy, int cz) {
+    const TerrainColumn* column = terrain_get_column(terrain, cx, cz);
+    int base_y = cy * CHUNK_SIZE;
+
+    memset(blocks, 0, MAX_CHUNK_SIZE * sizeof(Block)); // air, unlit
+    if (!column || base_y > column->max_height) return;
+
+    // a stone column topped with grass, written in one pass per column
+    BlockType types[CHUNK_SIZE];
+    for (int y = 0; y < CHUNK_SIZE; y++) types[y] = BLOCK_STONE;
+
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            int top = column->heights[x * CHUNK_SIZE + z] - base_y;
+            if (top < 0) continue;
+
+            int count = top < CHUNK_SIZE ? top + 1 : CHUNK_SIZE;
+            if (top < CHUNK_SIZE) types[top] = BLOCK_GRASS;
+            chunk_blocks_set_column(blocks, x, z, 0, types, count);
+            if (top < CHUNK_SIZE) types[top] = BLOCK_STONE;
+        }
+    }
+}
+
+void terrain_carve_caves(TerrainGenerator* terrain, Block* blocks, int cx, int cy, int cz) {
+    const TerrainColumn* column = terrain_get_column(terrain, cx, cz);
+    int base_y = cy * CHUNK_SIZE;
+
+    // chunks above the highest surface have nothing to carve, skip the noise
+    if (!column || base_y >= column->max_height) return;
+
+    float xs[CHUNK_SIZE], ys[CHUNK_SIZE], zs[CHUNK_SIZE], density[CHUNK_SIZE];
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            int height = column->heights[x * CHUNK_SIZE + z];
+
+            // caves only carve below the surface, the only place 3D noise matters
+            int underground = 0;
+            for (int y = 0; y < CHUNK_SIZE && base_y + y < height; y++) {
+                xs[underground] = (cx * CHUNK_SIZE + x) * TERRAIN_CAVE_FREQUENCY;
+                ys[underground] = (base_y + y) * TERRAIN_CAVE_FREQUENCY;
+                zs[underground] = (cz * CHUNK_SIZE + z) * TERRAIN_CAVE_FREQUENCY;
+                underground++;
+            }
+            noise_perlin_3d_batch(&terrain->noise, xs, ys, zs, density, underground);
+
+            for (int y = 0; y < underground; y++) {
+                if (base_y + y > 0 && (density[y] + 1.0f) * 0.5f > TERRAIN_CAVE_THRESHOLD) {
+                    blocks[chunk_get_block_index(x, y, z)].type = BLOCK_AIR;
+                }
+            }
+        }
+    }
+}
+
+static uint32_t terrain_hash(uint64_t seed, int x, int z) {
+    uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)z * 19349663u ^ (uint32_t)seed ^ (uint32_t)(seed >> 32);
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    return h;
+}
+
+void terrain_decorate(TerrainGenerator* terrain, Block* blocks, int cx, int cy, int cz) {
+    const TerrainColumn* column = terrain_get_column(terrain, cx, cz);
+    if (!column) return;
+    int base_y = cy * CHUNK_SIZE;
+
+    // lamps on a sparse, position dependent set of columns, each chunk only
+    // writes the ones standing inside it so chunks stay independent
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            int y = column->heights[x * CHUNK_SIZE + z] + 1 - base_y;
+            if (y < 0 || y >= CHUNK_SIZE) continue;
+            if (terrain_hash(terrain->noise.seed, cx * CHUNK_SIZE + x, cz * CHUNK_SIZE + z) % TERRAIN_LAMP_RARITY != 0) continue;
+
+            blocks[chunk_get_block_index(x, y, z)].type = BLOCK_LIGHT;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chunk.h"
+#include "noise.h"
+#include "thread.h"
+
+#define TERRAIN_BASE_HEIGHT 20     // surface height where the noise is zero
+#define TERRAIN_HEIGHT_RANGE 12    // blocks above and below the base
+#define TERRAIN_FREQUENCY 0.02f
+#define TERRAIN_OCTAVES 6
+#define TERRAIN_CAVE_FREQUENCY 0.1f
+#define TERRAIN_CAVE_THRESHOLD 0.6f
+#define TERRAIN_LAMP_RARITY 61 // about one surface column in this many gets a lamp
+
+// surface heights depend only on x and z, so they are computed once per chunk
+// column and reused by every chunk stacked in it
+typedef struct {
+    int16_t heights[CHUNK_SIZE * CHUNK_SIZE]; // index x * CHUNK_SIZE + z
+    int16_t max_height;
+    volatile int cached; // set with release once the heights are written, see terrain_get_column
+    Mutex mutex;         // held by the thread building the column
+} TerrainColumn;
+
+typedef struct {
+    NoiseContext noise; // read-only once initialized, shared by generator threads
+    TerrainColumn* columns;
+    int columns_x;
+    int columns_z;
+} TerrainGenerator;
+
+void terrain_init(TerrainGenerator* terrain, uint64_t seed, int columns_x, int columns_z);
+void terrain_free(TerrainGenerator* terrain);
+
+const TerrainColumn* terrain_get_column(TerrainGenerator* terrain, int cx, int cz);
+int terrain_get_height(TerrainGenerator* terrain, int x, int z); // world block coordinates
+
+// generation stages, run in this order on a chunk's MAX_CHUNK_SIZE blocks;
+// chunk coordinates index the world grid and each stage only writes its own chunk
+void terrain_fill(TerrainGenerator* terrain, Block* blocks, int cx, int cy, int cz);
+void terrain_carve_caves(TerrainGenerator* terrain, Block* blocks, int cx, int cy, int cz);
+void terrain_decorate(TerrainGenerator* terrain, Block* blocks, int cx, int cy, int cz);
+
+#endif // TERRAIN_H
@@ -53,6 +53,86 @@ static void texture_load(Texture* texture) {
     stbi_image_free(data);
 }
 
+void texture_upload_array(Texture* texture, const unsigned char* pixels, int width, int height, int tiles_x, int tiles_y) {
+    if (width % tiles_x != 0 || height % tiles_y != 0) {
+        fprintf(stderr, "TEXTURE: %dx%d atlas does not split into %dx%d tiles\n", width, height, tiles_x, tiles_y);
+        return;
+    }
+
+    int tile_width = width / tiles_x;
+    int tile_height = height / tiles_y;
+    int layers = tiles_x * tiles_y;
+    size_t size = (size_t)width * height * 4;
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture->ID);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // storage first, a bound unpack buffer would turn the NULL into an offset
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, tile_width, tile_height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    // stream the pixels through a pixel buffer so the copy to the gpu is asynchronous
+    GLuint pbo;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+    const unsigned char* source = NULL; // offset into the pixel buffer
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped) {
+        memcpy(mapped, pixels, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        source = pixels;
+    }
+
+    // each layer is a window into the whole image, rows are flipped on load
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+    for (int layer = 0; layer < layers; layer++) {
+        int tile_x = layer % tiles_x;
+        int tile_y = tiles_y - 1 - layer / tiles_x;
+
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, tile_x * tile_width);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, tile_y * tile_height);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, tile_width, tile_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, source);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pbo); // freed by the driver once the copy is done
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+static void texture_load_array(Texture* texture, int tiles_x, int tiles_y) {
+    glGenTextures(1, &texture->ID);
+
+    int width, height, nr_channels;
+    stbi_set_flip_vertically_on_load(1);
+    unsigned char* data = stbi_load(texture->file_path, &width, &height, &nr_channels, 4);
+    if (!data) {
+        fprintf(stderr, "TEXTURE: Failed to load texture at path: %s\n", texture->file_path);
+        return;
+    }
+
+    texture_upload_array(texture, data, width, height, tiles_x, tiles_y);
+    stbi_image_free(data);
+}
+
+Texture texture_create_array(const char* file_path, int tiles_x, int tiles_y) {
+    Texture texture;
+    texture.texture_type = GL_TEXTURE_2D_ARRAY;
+    texture.file_path = file_path;
+    texture.ID = 0;
+
+    texture_load_array(&texture, tiles_x, tiles_y);
+    return texture;
+}
+
 Texture texture_create(const char* file_path, GLenum texture_type) {
     Texture texture;
     texture.texture_type = texture_type;
@@ -10,6 +10,11 @@ typedef struct {
 } Texture;
 
 Texture texture_create(const char* filePath, GLenum type);
+// slices a tiles_x by tiles_y atlas into GL_TEXTURE_2D_ARRAY layers, numbered
+// left to right from the top row, so faces can repeat a tile with GL_REPEAT
+Texture texture_create_array(const char* file_path, int tiles_x, int tiles_y);
+// pixels are rgba rows bottom up, as stbi_load returns them with flipping on
+void texture_upload_array(Texture* texture, const unsigned char* pixels, int width, int height, int tiles_x, int tiles_y);
 void texture_bind(const Texture* texture, GLuint unit);
 void texture_unbind(const Texture* texture);
 void texture_destroy(Texture* texture);
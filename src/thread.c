@@ -0,0 +1,85 @@
+#include "thread.h"
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    Thread* thread = param;
+    thread->func(thread->arg);
+    return 0;
+}
+
+bool thread_create(Thread* thread, ThreadFunc func, void* arg) {
+    thread->func = func;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    if (!thread->handle) {
+        fprintf(stderr, "THREAD: failed to create thread\n");
+        return false;
+    }
+    return true;
+}
+
+void thread_join(Thread* thread) {
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+int thread_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+void mutex_init(Mutex* mutex) { InitializeCriticalSection(mutex); }
+void mutex_destroy(Mutex* mutex) { DeleteCriticalSection(mutex); }
+void mutex_lock(Mutex* mutex) { EnterCriticalSection(mutex); }
+void mutex_unlock(Mutex* mutex) { LeaveCriticalSection(mutex); }
+
+void cond_init(CondVar* cond) { InitializeConditionVariable(cond); }
+void cond_destroy(CondVar* cond) { (void)cond; }
+void cond_wait(CondVar* cond, Mutex* mutex) { SleepConditionVariableCS(cond, mutex, INFINITE); }
+void cond_signal(CondVar* cond) { WakeConditionVariable(cond); }
+void cond_broadcast(CondVar* cond) { WakeAllConditionVariable(cond); }
+
+#else
+#include <unistd.h>
+
+static void* thread_entry(void* param) {
+    Thread* thread = param;
+    thread->func(thread->arg);
+    return NULL;
+}
+
+bool thread_create(Thread* thread, ThreadFunc func, void* arg) {
+    thread->func = func;
+    thread->arg = arg;
+    if (pthread_create(&thread->handle, NULL, thread_entry, thread) != 0) {
+        fprintf(stderr, "THREAD: failed to create thread\n");
+        return false;
+    }
+    return true;
+}
+
+void thread_join(Thread* thread) {
+    pthread_join(thread->handle, NULL);
+}
+
+int thread_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+void mutex_init(Mutex* mutex) { pthread_mutex_init(mutex, NULL); }
+void mutex_destroy(Mutex* mutex) { pthread_mutex_destroy(mutex); }
+void mutex_lock(Mutex* mutex) { pthread_mutex_lock(mutex); }
+void mutex_unlock(Mutex* mutex) { pthread_mutex_unlock(mutex); }
+
+void cond_init(CondVar* cond) { pthread_cond_init(cond, NULL); }
+void cond_destroy(CondVar* cond) { pthread_cond_destroy(cond); }
+void cond_wait(CondVar* cond, Mutex* mutex) { pthread_cond_wait(cond, mutex); }
+void cond_signal(CondVar* cond) { pthread_cond_signal(cond); }
+void cond_broadcast(CondVar* cond) { pthread_cond_broadcast(cond); }
+
+#endif
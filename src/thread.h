@@ -0,0 +1,58 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdbool.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+typedef HANDLE ThreadHandle;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE CondVar;
+#else
+#include <pthread.h>
+typedef pthread_t ThreadHandle;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t CondVar;
+#endif
+
+typedef void (*ThreadFunc)(void* arg);
+
+typedef struct {
+    ThreadHandle handle;
+    ThreadFunc func;
+    void* arg;
+} Thread;
+
+bool thread_create(Thread* thread, ThreadFunc func, void* arg); // thread must stay valid until joined
+void thread_join(Thread* thread);
+int thread_cpu_count(void);
+
+void mutex_init(Mutex* mutex);
+void mutex_destroy(Mutex* mutex);
+void mutex_lock(Mutex* mutex);
+void mutex_unlock(Mutex* mutex);
+
+void cond_init(CondVar* cond);
+void cond_destroy(CondVar* cond);
+void cond_wait(CondVar* cond, Mutex* mutex);
+void cond_signal(CondVar* cond);
+void cond_broadcast(CondVar* cond);
+
+// flags set once by one thread and polled by others before taking a lock
+static inline int atomic_load_acquire(const volatile int* value) {
+#if defined(_MSC_VER)
+    return (int)InterlockedCompareExchange((volatile LONG*)value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void atomic_store_release(volatile int* value, int new_value) {
+#if defined(_MSC_VER)
+    InterlockedExchange((volatile LONG*)value, new_value);
+#else
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+#endif
+}
+
+#endif // THREAD_H
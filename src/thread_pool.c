@@ -0,0 +1,106 @@
+#include "thread_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void pool_worker(void* arg) {
+    ThreadPool* pool = arg;
+
+    mutex_lock(&pool->mutex);
+    while (true) {
+        while (pool->running && !pool->head) {
+            cond_wait(&pool->job_cond, &pool->mutex);
+        }
+        if (!pool->head) break; // stopped and drained
+
+        ThreadPoolJob* job = pool->head;
+        pool->head = job->next;
+        if (!pool->head) pool->tail = NULL;
+        mutex_unlock(&pool->mutex);
+
+        job->func(job->arg);
+        free(job);
+
+        mutex_lock(&pool->mutex);
+        if (--pool->pending == 0) cond_broadcast(&pool->idle_cond);
+    }
+    mutex_unlock(&pool->mutex);
+}
+
+bool thread_pool_init(ThreadPool* pool, int thread_count) {
+    memset(pool, 0, sizeof(*pool));
+    if (thread_count <= 0) {
+        thread_count = thread_cpu_count() - 1; // leave the main thread its core
+        if (thread_count < 1) thread_count = 1;
+    }
+
+    mutex_init(&pool->mutex);
+    cond_init(&pool->job_cond);
+    cond_init(&pool->idle_cond);
+    pool->running = true;
+
+    pool->threads = calloc(thread_count, sizeof(Thread));
+    if (!pool->threads) {
+        fprintf(stderr, "THREAD: failed to allocate pool\n");
+        return false;
+    }
+    for (int i = 0; i < thread_count; i++) {
+        if (!thread_create(&pool->threads[i], pool_worker, pool)) break;
+        pool->thread_count++;
+    }
+    return pool->thread_count > 0;
+}
+
+void thread_pool_free(ThreadPool* pool) {
+    mutex_lock(&pool->mutex);
+    pool->running = false;
+    cond_broadcast(&pool->job_cond);
+    mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        thread_join(&pool->threads[i]);
+    }
+
+    // without workers nothing ran the queue
+    while (pool->head) {
+        ThreadPoolJob* job = pool->head;
+        pool->head = job->next;
+        job->func(job->arg);
+        free(job);
+    }
+
+    cond_destroy(&pool->idle_cond);
+    cond_destroy(&pool->job_cond);
+    mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void thread_pool_submit(ThreadPool* pool, ThreadFunc func, void* arg) {
+    ThreadPoolJob* job = malloc(sizeof(ThreadPoolJob));
+    if (!job || pool->thread_count == 0) {
+        free(job);
+        func(arg); // run inline rather than drop the work
+        return;
+    }
+    job->func = func;
+    job->arg = arg;
+    job->next = NULL;
+
+    mutex_lock(&pool->mutex);
+    if (pool->tail) pool->tail->next = job;
+    else pool->head = job;
+    pool->tail = job;
+    pool->pending++;
+    cond_signal(&pool->job_cond);
+    mutex_unlock(&pool->mutex);
+}
+
+void thread_pool_wait(ThreadPool* pool) {
+    mutex_lock(&pool->mutex);
+    while (pool->pending > 0) {
+        cond_wait(&pool->idle_cond, &pool->mutex);
+    }
+    mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,34 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+
+#include "thread.h"
+
+typedef struct ThreadPoolJob {
+    ThreadFunc func;
+    void* arg;
+    struct ThreadPoolJob* next;
+} ThreadPoolJob;
+
+// fixed set of workers taking jobs from one fifo queue
+typedef struct {
+    Thread* threads;
+    int thread_count;
+
+    Mutex mutex;
+    CondVar job_cond;  // signaled when a job is queued or the pool stops
+    CondVar idle_cond; // signaled when the last pending job finishes
+
+    ThreadPoolJob* head;
+    ThreadPoolJob* tail;
+    int pending; // queued plus running
+    bool running;
+} ThreadPool;
+
+bool thread_pool_init(ThreadPool* pool, int thread_count); // thread_count <= 0 uses one per spare core
+void thread_pool_free(ThreadPool* pool); // finishes queued jobs first
+void thread_pool_submit(ThreadPool* pool, ThreadFunc func, void* arg);
+void thread_pool_wait(ThreadPool* pool); // until every submitted job has finished
+
+#endif // THREAD_POOL_H
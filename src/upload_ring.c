@@ -0,0 +1,100 @@
+#include "upload_ring.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define FENCE_TIMEOUT 1000000000 // ns
+
+static void ring_fence(UploadRing* ring, int segment) {
+    if (ring->fences[segment]) glDeleteSync(ring->fences[segment]);
+    ring->fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// blocks until the gpu has finished copying out of the segment
+static void ring_wait(UploadRing* ring, int segment) {
+    if (!ring->fences[segment]) return;
+
+    GLenum status;
+    do {
+        status = glClientWaitSync(ring->fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+    } while (status == GL_TIMEOUT_EXPIRED);
+
+    if (status == GL_WAIT_FAILED) {
+        fprintf(stderr, "UPLOAD: fence wait failed\n");
+    }
+    glDeleteSync(ring->fences[segment]);
+    ring->fences[segment] = 0;
+}
+
+bool upload_ring_init(UploadRing* ring, size_t size) {
+    memset(ring, 0, sizeof(*ring));
+    if (!GLAD_GL_ARB_buffer_storage) return false;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &ring->buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, ring->buffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, size, NULL, flags);
+    ring->mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, flags);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    if (!ring->mapped) {
+        fprintf(stderr, "UPLOAD: failed to map staging ring\n");
+        glDeleteBuffers(1, &ring->buffer);
+        ring->buffer = 0;
+        return false;
+    }
+    ring->size = size;
+    return true;
+}
+
+void upload_ring_free(UploadRing* ring) {
+    for (int i = 0; i < UPLOAD_RING_SEGMENTS; i++) {
+        if (ring->fences[i]) glDeleteSync(ring->fences[i]);
+    }
+    if (ring->mapped) {
+        glBindBuffer(GL_COPY_READ_BUFFER, ring->buffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    if (ring->buffer) glDeleteBuffers(1, &ring->buffer);
+    memset(ring, 0, sizeof(*ring));
+}
+
+void upload_ring_copy(UploadRing* ring, GLuint dest, GLintptr offset, const void* data, size_t size) {
+    if (size == 0) return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, dest);
+
+    size_t segment_size = ring->size / UPLOAD_RING_SEGMENTS;
+    if (!ring->mapped || size > segment_size) {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return;
+    }
+
+    // a copy never spans two segments, otherwise the first would be fenced
+    // before the copy still reading from it is issued
+    size_t begin = ring->head;
+    if (begin / segment_size != (begin + size - 1) / segment_size) {
+        begin = (begin / segment_size + 1) * segment_size;
+    }
+    if (begin + size > ring->size) begin = 0; // wrap
+
+    // every copy out of the segments left behind has been issued, fence them
+    // and wait for the one entered
+    int last = (int)(begin / segment_size);
+    while (ring->segment != last) {
+        ring_fence(ring, ring->segment);
+        ring->segment = (ring->segment + 1) % UPLOAD_RING_SEGMENTS;
+        ring_wait(ring, ring->segment);
+    }
+
+    memcpy(ring->mapped + begin, data, size);
+    ring->head = begin + size;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, ring->buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, begin, offset, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
@@ -0,0 +1,31 @@
+#ifndef UPLOAD_RING_H
+#define UPLOAD_RING_H
+
+#include <glad.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UPLOAD_RING_SIZE (4 * 1024 * 1024)
+#define UPLOAD_RING_SEGMENTS 4
+
+// persistently mapped staging buffer, data is written on the cpu and copied into
+// the destination buffer on the gpu; an upload never spans two segments, each
+// is fenced once the ring moves past it and waited on before it is written again
+typedef struct {
+    GLuint buffer;
+    unsigned char* mapped; // NULL when buffer storage is unavailable
+    size_t size;
+    size_t head;           // next free byte
+    int segment;           // segment head is in
+    GLsync fences[UPLOAD_RING_SEGMENTS];
+} UploadRing;
+
+// returns false and leaves the ring unmapped when ARB_buffer_storage is missing,
+// upload_ring_copy then writes straight into the destination
+bool upload_ring_init(UploadRing* ring, size_t size);
+void upload_ring_free(UploadRing* ring);
+
+// the destination must already have at least offset + size bytes of storage
+void upload_ring_copy(UploadRing* ring, GLuint dest, GLintptr offset, const void* data, size_t size);
+
+#endif // UPLOAD_RING_H
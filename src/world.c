@@ -1,6 +1,5 @@
 #include "world.h"
 #include "frustum.h"
-#include "perlin.h"
 
 int world_get_chunk_index(int x, int y, int z) {
     if (x < 0 || x >= WORLD_SIZE_X || y < 0 || y >= WORLD_SIZE_Y || z < 0 || z >= WORLD_SIZE_Z) {
@@ -88,17 +87,239 @@ void world_set_block(World* world, int x, int y, int z, BlockType block) { // id
     int block_z = z % CHUNK_SIZE;
 
     Chunk* chunk = &world->chunks[world_get_chunk_index(chunk_x, chunk_y, chunk_z)];
-    chunk->blocks[chunk_get_block_index(block_x, block_y, block_z)].type = block;
+    Block* target = &chunk->blocks[chunk_get_block_index(block_x, block_y, block_z)];
+    if (block_is_transparent(target->type) != block_is_transparent(block)) chunk->shape_dirty = true;
+    target->type = block;
+    chunk->generation++;
+    world_mark_block_dirty(world, x, y, z);
 }
 
-void world_init(World* world) {
+void world_mark_block_dirty(World* world, int x, int y, int z) {
+    int chunk_x = x / CHUNK_SIZE;
+    int chunk_y = y / CHUNK_SIZE;
+    int chunk_z = z / CHUNK_SIZE;
+
+    int block_x = x % CHUNK_SIZE;
+    int block_y = y % CHUNK_SIZE;
+    int block_z = z % CHUNK_SIZE;
+
+    Chunk* chunk = world_get_chunk(world, chunk_x, chunk_y, chunk_z);
+    if (!chunk) return;
+    chunk_mark_dirty(chunk, block_y);
+
+    // blocks on a border also show up in the neighbor's mesh
+    Chunk* neighbor;
+    if (block_x == 0 && (neighbor = chunk_get_neighbor(world, chunk_x, chunk_y, chunk_z, DIR_NEG_X)))
+        chunk_mark_dirty(neighbor, block_y);
+    if (block_x == CHUNK_SIZE - 1 && (neighbor = chunk_get_neighbor(world, chunk_x, chunk_y, chunk_z, DIR_POS_X)))
+        chunk_mark_dirty(neighbor, block_y);
+    if (block_y == 0 && (neighbor = chunk_get_neighbor(world, chunk_x, chunk_y, chunk_z, DIR_NEG_Y)))
+        chunk_mark_dirty(neighbor, CHUNK_SIZE - 1);
+    if (block_y == CHUNK_SIZE - 1 && (neighbor = chunk_get_neighbor(world, chunk_x, chunk_y, chunk_z, DIR_POS_Y)))
+        chunk_mark_dirty(neighbor, 0);
+    if (block_z == 0 && (neighbor = chunk_get_neighbor(world, chunk_x, chunk_y, chunk_z, DIR_NEG_Z)))
+        chunk_mark_dirty(neighbor, block_y);
+    if (block_z == CHUNK_SIZE - 1 && (neighbor = chunk_get_neighbor(world, chunk_x, chunk_y, chunk_z, DIR_POS_Z)))
+        chunk_mark_dirty(neighbor, block_y);
+}
+
+void world_mark_box_dirty(World* world, int x0, int y0, int z0, int x1, int y1, int z1) {
+    // one block of margin reaches the neighbors showing faces against the box,
+    // diagonal chunks at its corners get an extra section rebuilt at worst
+    x0 = x0 - 1 < 0 ? 0 : x0 - 1;
+    y0 = y0 - 1 < 0 ? 0 : y0 - 1;
+    z0 = z0 - 1 < 0 ? 0 : z0 - 1;
+    x1 = x1 + 1 > CHUNK_SIZE * WORLD_SIZE_X ? CHUNK_SIZE * WORLD_SIZE_X : x1 + 1;
+    y1 = y1 + 1 > CHUNK_SIZE * WORLD_SIZE_Y ? CHUNK_SIZE * WORLD_SIZE_Y : y1 + 1;
+    z1 = z1 + 1 > CHUNK_SIZE * WORLD_SIZE_Z ? CHUNK_SIZE * WORLD_SIZE_Z : z1 + 1;
+    if (x0 >= x1 || y0 >= y1 || z0 >= z1) return;
+
+    for (int cx = x0 / CHUNK_SIZE; cx <= (x1 - 1) / CHUNK_SIZE; cx++) {
+        for (int cy = y0 / CHUNK_SIZE; cy <= (y1 - 1) / CHUNK_SIZE; cy++) {
+            for (int cz = z0 / CHUNK_SIZE; cz <= (z1 - 1) / CHUNK_SIZE; cz++) {
+                Chunk* chunk = &world->chunks[world_get_chunk_index(cx, cy, cz)];
+                chunk_mark_dirty_range(chunk, y0 - cy * CHUNK_SIZE, y1 - cy * CHUNK_SIZE);
+            }
+        }
+    }
+}
+
+void world_fill_box(World* world, int x0, int y0, int z0, int x1, int y1, int z1, BlockType block) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (z0 < 0) z0 = 0;
+    if (x1 > CHUNK_SIZE * WORLD_SIZE_X) x1 = CHUNK_SIZE * WORLD_SIZE_X;
+    if (y1 > CHUNK_SIZE * WORLD_SIZE_Y) y1 = CHUNK_SIZE * WORLD_SIZE_Y;
+    if (z1 > CHUNK_SIZE * WORLD_SIZE_Z) z1 = CHUNK_SIZE * WORLD_SIZE_Z;
+    if (x0 >= x1 || y0 >= y1 || z0 >= z1) return;
+
+    // resolve each chunk once and let it clip the box to itself
+    for (int cx = x0 / CHUNK_SIZE; cx <= (x1 - 1) / CHUNK_SIZE; cx++) {
+        for (int cy = y0 / CHUNK_SIZE; cy <= (y1 - 1) / CHUNK_SIZE; cy++) {
+            for (int cz = z0 / CHUNK_SIZE; cz <= (z1 - 1) / CHUNK_SIZE; cz++) {
+                Chunk* chunk = &world->chunks[world_get_chunk_index(cx, cy, cz)];
+                int ox = cx * CHUNK_SIZE, oy = cy * CHUNK_SIZE, oz = cz * CHUNK_SIZE;
+                chunk_blocks_fill_box(chunk->blocks, x0 - ox, y0 - oy, z0 - oz, x1 - ox, y1 - oy, z1 - oz, block);
+                chunk->generation++;
+                chunk->shape_dirty = true;
+            }
+        }
+    }
+    world_mark_box_dirty(world, x0, y0, z0, x1, y1, z1);
+}
+
+// takes ownership of blocks, light already in them is kept as is
+static void world_install_chunk(World* world, int chunk_index, int cx, int cy, int cz, Block* blocks) {
+    Chunk* chunk = &world->chunks[chunk_index];
+    free(chunk->blocks);
+    chunk->blocks = blocks;
+
+    lightqueue_init(&chunk->light_queue);
+    lightqueue_init(&chunk->border_light_queue);
+    chunk->generation = chunk->saved_generation = chunk->queued_generation = 0;
+    chunk->active = true;
+    chunk->dirty = true;
+
+    // neighbors mesh their border against this chunk
+    for (Direction d = 0; d < DIR_COUNT; d++) {
+        Chunk* neighbor = chunk_get_neighbor(world, cx, cy, cz, d);
+        if (neighbor) neighbor->dirty = true;
+    }
+}
+
+static void world_push_light(void* user, LightNode node) {
+    Chunk* chunk = user;
+    lightqueue_push(&chunk->light_queue, node);
+}
+
+static void world_io_complete(void* user, ChunkIORequest* request) {
+    World* world = user;
+
+    if (request->type == CHUNK_IO_SAVE) {
+        Chunk* chunk = &world->chunks[request->chunk_index];
+        if (request->success) {
+            chunk->saved_generation = request->generation;
+        } else {
+            // let the next autosave pass try again
+            fprintf(stderr, "WORLD: failed to save chunk %d %d %d\n", request->cx, request->cy, request->cz);
+            chunk->queued_generation = chunk->saved_generation;
+        }
+        return;
+    }
+
+    // saved chunks keep their light, missing ones are generated. emitters are
+    // queued again so their light reaches neighbors generated after the load
+    if (request->success) {
+        Chunk* chunk = &world->chunks[request->chunk_index];
+        world_install_chunk(world, request->chunk_index, request->cx, request->cy, request->cz, request->blocks);
+        request->blocks = NULL;
+        chunk_gen_seed_light(chunk->blocks, request->cx, request->cy, request->cz, world_push_light, chunk);
+    } else {
+        chunk_gen_request(&world->generator, request->chunk_index, request->cx, request->cy, request->cz);
+    }
+}
+
+static bool world_read_meta(const char* directory, uint64_t* seed) {
+    char path[1100];
+    snprintf(path, sizeof(path), "%s/world.dat", directory);
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    uint8_t data[16];
+    bool ok = fread(data, 1, sizeof(data), file) == sizeof(data);
+    fclose(file);
+
+    uint32_t magic = 0, version = 0;
+    uint64_t value = 0;
+    for (int i = 3; ok && i >= 0; i--) {
+        magic = magic << 8 | data[i];
+        version = version << 8 | data[4 + i];
+    }
+    for (int i = 7; ok && i >= 0; i--) {
+        value = value << 8 | data[8 + i];
+    }
+    if (!ok || magic != WORLD_META_MAGIC || version != WORLD_META_VERSION) {
+        fprintf(stderr, "WORLD: ignoring invalid %s\n", path);
+        return false;
+    }
+    *seed = value;
+    return true;
+}
+
+static bool world_write_meta(const char* directory, uint64_t seed) {
+    char path[1100];
+    snprintf(path, sizeof(path), "%s/world.dat", directory);
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "WORLD: failed to write %s\n", path);
+        return false;
+    }
+
+    uint8_t data[16];
+    for (int i = 0; i < 4; i++) {
+        data[i] = (uint8_t)(WORLD_META_MAGIC >> (i * 8));
+        data[4 + i] = (uint8_t)(WORLD_META_VERSION >> (i * 8));
+    }
+    for (int i = 0; i < 8; i++) {
+        data[8 + i] = (uint8_t)(seed >> (i * 8));
+    }
+    bool ok = fwrite(data, 1, sizeof(data), file) == sizeof(data);
+    return fclose(file) == 0 && ok;
+}
+
+void world_init(World* world, uint64_t seed, const char* save_directory) {
     world->chunks = malloc(MAX_WORLD_SIZE * sizeof(Chunk));
     memset(world->chunks, 0, MAX_WORLD_SIZE * sizeof(Chunk));
 
     for(int i = 0; i < MAX_WORLD_SIZE; i++) {
         chunk_init(&world->chunks[i], i);
     }
-	world_generate(world);
+
+    // blocks are centered on integer coordinates, so chunks span [-0.5, CHUNK_SIZE - 0.5)
+    chunk_bounds_init(&world->bounds, MAX_WORLD_SIZE);
+    world->visible_chunks = malloc(MAX_WORLD_SIZE * sizeof(int));
+    world->visible_count = 0;
+    world->draw_items = malloc(MAX_WORLD_SIZE * sizeof(ChunkDrawItem));
+    memset(&world->occlusion, 0, sizeof(world->occlusion));
+    world->occlusion_buffer = malloc(sizeof(OcclusionBuffer));
+    world->software_occlusion = true;
+    world->lod_distance[0] = LOD_DISTANCE_1;
+    world->lod_distance[1] = LOD_DISTANCE_2;
+    world->lod_distance[2] = LOD_DISTANCE_3;
+
+    world->cull_queue = malloc(MAX_WORLD_SIZE * sizeof(int));
+    world->cull_entry_face = malloc(MAX_WORLD_SIZE * sizeof(uint8_t));
+    world->cull_traveled = malloc(MAX_WORLD_SIZE * sizeof(uint8_t));
+    world->cull_reached = calloc(MAX_WORLD_SIZE, sizeof(bool));
+    for(int i = 0; i < MAX_WORLD_SIZE; i++) {
+        int x = i / (WORLD_SIZE_Y * WORLD_SIZE_Z);
+        int y = (i / WORLD_SIZE_Z) % WORLD_SIZE_Y;
+        int z = i % WORLD_SIZE_Z;
+
+        vec3 box_min = {
+            x * CHUNK_SIZE - 0.5f,
+            y * CHUNK_SIZE - 0.5f,
+            z * CHUNK_SIZE - 0.5f
+        };
+        vec3 box_max = {
+            box_min[0] + CHUNK_SIZE,
+            box_min[1] + CHUNK_SIZE,
+            box_min[2] + CHUNK_SIZE
+        };
+        chunk_bounds_set(&world->bounds, i, box_min, box_max);
+    }
+    chunk_tree_init(&world->tree, &world->bounds, WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z, world_get_chunk_index);
+
+    // chunks missing from the save are generated, with the seed they were saved with
+    region_store_init(&world->regions, save_directory);
+    if (!world_read_meta(save_directory, &seed)) world_write_meta(save_directory, seed);
+    world->seed = seed;
+    terrain_init(&world->terrain, seed, WORLD_SIZE_X, WORLD_SIZE_Z);
+    chunk_gen_init(&world->generator, &world->terrain);
+    chunk_io_init(&world->io, &world->regions, world_io_complete, world);
+    world->autosave_timer = 0.0f;
+    world->autosave_cursor = MAX_WORLD_SIZE;
+	world_load(world);
 }
 
 void world_unload(World* world) {
@@ -106,77 +327,145 @@ void world_unload(World* world) {
 
     int chunk_count = MAX_WORLD_SIZE;
 
+    // workers may still be writing generated chunks, queued saves are flushed
+    chunk_gen_free(&world->generator);
+    chunk_io_free(&world->io);
+
     for (int i = 0; i < chunk_count; i++) {
         chunk_unload(&world->chunks[i]);
     }
 
     free(world->chunks);
     world->chunks = NULL;
+    chunk_free_staging();
+
+    chunk_tree_free(&world->tree);
+    terrain_free(&world->terrain);
+    region_store_free(&world->regions);
+    chunk_bounds_free(&world->bounds);
+    free(world->visible_chunks);
+    world->visible_chunks = NULL;
+    free(world->draw_items);
+    world->draw_items = NULL;
+    occlusion_free(&world->occlusion);
+    free(world->occlusion_buffer);
+    world->occlusion_buffer = NULL;
+
+    free(world->cull_queue);
+    free(world->cull_entry_face);
+    free(world->cull_traveled);
+    free(world->cull_reached);
+    world->cull_queue = NULL;
+    world->cull_entry_face = NULL;
+    world->cull_traveled = NULL;
+    world->cull_reached = NULL;
+}
+
+void world_load(World* world) {
+    for(int i = 0; i < MAX_WORLD_SIZE; i++) {
+        int x = i / (WORLD_SIZE_Y * WORLD_SIZE_Z);
+        int y = (i / WORLD_SIZE_Z) % WORLD_SIZE_Y;
+        int z = i % WORLD_SIZE_Z;
+        chunk_io_load(&world->io, i, x, y, z);
+    }
+
+    // chunks missing from disk are queued for generation by the completions
+    chunk_io_wait(&world->io);
+    chunk_io_poll(&world->io);
+    chunk_gen_wait(&world->generator);
+    int generated = world_publish_generated(world);
+    printf("WORLD: generated %d of %d chunks, read the rest\n", generated, MAX_WORLD_SIZE);
+}
+
+// snapshots the chunk for the io thread if it changed since it was last saved or queued
+static bool world_queue_save(World* world, int index) {
+    Chunk* chunk = &world->chunks[index];
+    if (!chunk->blocks) return false;
+    if (chunk->generation == chunk->saved_generation || chunk->generation == chunk->queued_generation) return false;
+
+    int x = index / (WORLD_SIZE_Y * WORLD_SIZE_Z);
+    int y = (index / WORLD_SIZE_Z) % WORLD_SIZE_Y;
+    int z = index % WORLD_SIZE_Z;
+    chunk_io_save(&world->io, index, x, y, z, chunk->blocks, chunk->generation);
+    chunk->queued_generation = chunk->generation;
+    return true;
 }
 
-void world_generate(World* world) {
-	for (int x = 0; x < WORLD_SIZE_X * CHUNK_SIZE; x++) {
-        for (int y = 0; y < WORLD_SIZE_Y * CHUNK_SIZE; y++) {
-            for (int z = 0; z < WORLD_SIZE_Z * CHUNK_SIZE; z++) {
-				world_set_block(world, x, 0, z, BLOCK_GRASS);
-			}
-		}
-	}
-
-	// world_set_block(world, 0, 1, 0, BLOCK_LIGHT);
-	// world_set_block(world, 0, 2, 0, BLOCK_GRASS);
-	// world_set_block(world, 6, 2, 6, BLOCK_GRASS);
-
-	/*
-	int p[512];
-	init_perlin(p);
-
-	const int MAX_HEIGHT = 2;
-
-	for (int x = 0; x < WORLD_SIZE_X * CHUNK_SIZE; x++) {
-        for (int y = 0; y < WORLD_SIZE_Y * CHUNK_SIZE; y++) {
-            for (int z = 0; z < WORLD_SIZE_Z * CHUNK_SIZE; z++) {
-                
-                float nx = x * 0.01f;
-                float nz = z * 0.01f;
-                float height = fbm(nx, 0.0f, nz, p, 6);
-                int terrain_height = (int)((height + 1.0f) * 0.5f * MAX_HEIGHT);
-
-                int block;
-
-                if (y < terrain_height - 3) {
-                    block = BLOCK_STONE;
-                } else if (y < terrain_height) {
-                    block = BLOCK_STONE;
-                } else if (y == terrain_height) {
-                    block = BLOCK_GRASS;
-                } else {
-                    block = BLOCK_AIR;
-                }
-
-                float cave_density = perlin_noise_3d(x * 0.1f, y * 0.1f, z * 0.1f, p);
-                float cave_value = (cave_density + 1.0f) * 0.5f;
-
-                if (cave_value > 0.6f && y < terrain_height) {
-                    block = BLOCK_AIR;
-                }
-
-                world_set_block(world, x, y, z, block);
+void world_save(World* world) {
+    // untouched chunks are left out, the seed regenerates them exactly
+    for (int i = 0; i < MAX_WORLD_SIZE; i++) {
+        world_queue_save(world, i);
+    }
+}
+
+void world_autosave(World* world, float delta_time) {
+    if (world->autosave_cursor >= MAX_WORLD_SIZE) {
+        world->autosave_timer += delta_time;
+        if (world->autosave_timer < WORLD_AUTOSAVE_INTERVAL) return;
+        world->autosave_timer = 0.0f;
+        world->autosave_cursor = 0;
+    }
+
+    // a pass is spread over frames, and waits while the io thread is behind
+    if (chunk_io_pending_saves(&world->io) >= WORLD_AUTOSAVE_MAX_PENDING) return;
+
+    int queued = 0;
+    while (world->autosave_cursor < MAX_WORLD_SIZE && queued < WORLD_AUTOSAVE_CHUNKS_PER_FRAME) {
+        if (world_queue_save(world, world->autosave_cursor)) queued++;
+        world->autosave_cursor++;
+    }
+}
+
+void world_poll(World* world, const vec3 focus) {
+    chunk_io_set_focus(&world->io, focus);
+    chunk_io_poll(&world->io);
+    world_publish_generated(world);
+}
+
+int world_publish_generated(World* world) {
+    int published = 0;
+    ChunkGenTask* task = chunk_gen_take_completed(&world->generator);
+
+    while (task) {
+        ChunkGenTask* next = task->next;
+        Chunk* chunk = &world->chunks[task->chunk_index];
+
+        if (task->blocks) {
+            world_install_chunk(world, task->chunk_index, task->cx, task->cy, task->cz, task->blocks);
+            task->blocks = NULL;
+            for (int l = 0; l < task->light_count; l++) {
+                lightqueue_push(&chunk->light_queue, task->lights[l]);
             }
+            published++;
         }
+
+        chunk_gen_task_free(task);
+        task = next;
     }
-	*/
+    return published;
+}
+
+void world_get_spawn(World* world, vec3 out_position) {
+    int x = WORLD_SIZE_X * CHUNK_SIZE / 2;
+    int z = WORLD_SIZE_Z * CHUNK_SIZE / 2;
+    int height = terrain_get_height(&world->terrain, x, z);
+
+    // entity positions are centers, keep the feet clear of the surface block
+    out_position[0] = (float)x;
+    out_position[1] = (float)height + 2.0f;
+    out_position[2] = (float)z;
 }
 
 void world_update_mesh(World* world) {
     for(int i = 0; i < MAX_WORLD_SIZE; i++) {
-        if(!world->chunks[i].dirty) continue;
+        if(!world->chunks[i].dirty && !world->chunks[i].dirty_sections) continue;
 
         int x = i / (WORLD_SIZE_Y * WORLD_SIZE_Z);
         int y = (i / WORLD_SIZE_Z) % WORLD_SIZE_Y;
         int z = i % WORLD_SIZE_Z;
 
         chunk_update_mesh(world, &world->chunks[i], x, y, z);
+        chunk_tree_set_geometry(&world->tree, i, chunk_index_count(&world->chunks[i]));
     }
 }
 
@@ -196,38 +485,245 @@ void world_update_light(World* world) {
     } while (any_active);
 }
 
-void world_draw(const RenderContext* ctx, World* world, Shader* shader) {
-	shader_use(shader);
-	shader_set_mat4(shader, "projection", ctx->projection);
-	shader_set_mat4(shader, "view", ctx->view);
-	
-    for(int i = 0; i < MAX_WORLD_SIZE; i++) {
-        Chunk* chunk = &world->chunks[i];
-        
+// breadth first search from the camera chunk that only leaves a chunk through faces
+// connected to the one it entered by, never turns back and stays inside the frustum.
+// drops chunks from the visible list that the search could not reach
+static void world_cull_occluded(World* world, const RenderContext* ctx) {
+    int cam_x = (int)floorf((ctx->camera_position[0] + 0.5f) / CHUNK_SIZE);
+    int cam_y = (int)floorf((ctx->camera_position[1] + 0.5f) / CHUNK_SIZE);
+    int cam_z = (int)floorf((ctx->camera_position[2] + 0.5f) / CHUNK_SIZE);
+
+    int start = world_get_chunk_index(cam_x, cam_y, cam_z);
+    if (start == -1) return; // outside the world, nothing to walk through
+
+    int head = 0;
+    int tail = 0;
+    world->cull_queue[tail++] = start;
+    world->cull_entry_face[start] = DIR_COUNT;
+    world->cull_traveled[start] = 0;
+    world->cull_reached[start] = true;
+
+    while (head < tail) {
+        int i = world->cull_queue[head++];
+        const Chunk* chunk = &world->chunks[i];
+
         int x = i / (WORLD_SIZE_Y * WORLD_SIZE_Z);
         int y = (i / WORLD_SIZE_Z) % WORLD_SIZE_Y;
         int z = i % WORLD_SIZE_Z;
-        
-        // rebuild mesh if dirty
-        if(chunk->dirty) chunk_update_mesh(world, chunk, x, y, z);
-        
-        // check if in frustum
-		chunk->visible = chunk_in_frustum(&ctx->frustum, x, y, z); // check in frustum
-        if(!chunk->visible) continue;
-
-        // set model matrix
-       	mat4 model;
-		glm_mat4_identity(model);
-		vec3 translation = {
-			x * CHUNK_SIZE,
-			y * CHUNK_SIZE,
-			z * CHUNK_SIZE
-		};
-		glm_translate(model, translation);
-		shader_set_mat4(shader, "model", model);
-
-		// draw chunk
-		chunk_draw(chunk, shader);
+
+        for (Direction d = 0; d < DIR_COUNT; ++d) {
+            Direction opposite = d ^ 1; // directions come in +/- pairs
+            uint8_t entry = world->cull_entry_face[i];
+
+            if (world->cull_traveled[i] & (1 << opposite)) continue;
+            if (entry != DIR_COUNT && !(chunk->face_connections[entry] & (1 << d))) continue;
+
+            int next = world_get_chunk_index(x + offset_x(d), y + offset_y(d), z + offset_z(d));
+            if (next == -1 || world->cull_reached[next]) continue;
+
+            vec3 box_min = { world->bounds.min_x[next], world->bounds.min_y[next], world->bounds.min_z[next] };
+            vec3 box_max = { world->bounds.max_x[next], world->bounds.max_y[next], world->bounds.max_z[next] };
+            int planes = 0x3F;
+            if (frustum_classify_aabb(&ctx->frustum, box_min, box_max, &planes) == FRUSTUM_OUTSIDE) continue;
+
+            world->cull_reached[next] = true;
+            world->cull_entry_face[next] = opposite;
+            world->cull_traveled[next] = world->cull_traveled[i] | (1 << d);
+            world->cull_queue[tail++] = next;
+        }
+    }
+
+    int kept = 0;
+    for (int v = 0; v < world->visible_count; v++) {
+        int i = world->visible_chunks[v];
+        if (world->cull_reached[i]) world->visible_chunks[kept++] = i;
+    }
+    world->visible_count = kept;
+
+    for (int q = 0; q < tail; q++) {
+        world->cull_reached[world->cull_queue[q]] = false;
+    }
+}
+
+// rasterizes the occluder layers of the nearest chunks, then drops every draw
+// item whose bounds are hidden behind them. expects draw_items sorted near to far
+static void world_cull_software(World* world, const RenderContext* ctx) {
+    OcclusionBuffer* buffer = world->occlusion_buffer;
+    occlusion_buffer_clear(buffer, ctx->projection, ctx->view);
+
+    int occluders = 0;
+    for (int v = 0; v < world->visible_count && occluders < OCCLUDER_CHUNK_COUNT; v++) {
+        int i = world->draw_items[v].chunk_index;
+        const Chunk* chunk = &world->chunks[i];
+
+        vec3 box_min = { world->bounds.min_x[i], world->bounds.min_y[i], world->bounds.min_z[i] };
+        vec3 box_max = { world->bounds.max_x[i], world->bounds.max_y[i], world->bounds.max_z[i] };
+        bool has_occluder = false;
+
+        for (int axis = 0; axis < 3; ++axis) {
+            if (chunk->occluder_layer[axis] == -1) continue;
+            has_occluder = true;
+
+            // plane through the block centers of the layer
+            int u = (axis + 1) % 3;
+            int w = (axis + 2) % 3;
+            float plane = box_min[axis] + 0.5f + chunk->occluder_layer[axis];
+
+            vec3 corners[4];
+            for (int c = 0; c < 4; ++c) {
+                corners[c][axis] = plane;
+                corners[c][u] = (c == 1 || c == 2) ? box_max[u] : box_min[u];
+                corners[c][w] = (c >= 2) ? box_max[w] : box_min[w];
+            }
+            occlusion_buffer_add_quad(buffer, corners);
+        }
+        if (has_occluder) occluders++;
     }
+    if (occluders == 0) return;
+
+    int kept = 0;
+    for (int v = 0; v < world->visible_count; v++) {
+        int i = world->draw_items[v].chunk_index;
+        vec3 box_min = { world->bounds.min_x[i], world->bounds.min_y[i], world->bounds.min_z[i] };
+        vec3 box_max = { world->bounds.max_x[i], world->bounds.max_y[i], world->bounds.max_z[i] };
+
+        if (occlusion_buffer_test_aabb(buffer, box_min, box_max)) {
+            world->visible_chunks[kept] = i;
+            world->draw_items[kept++] = world->draw_items[v];
+        } else {
+            world->chunks[i].visible = false;
+        }
+    }
+    world->visible_count = kept;
 }
 
+static int compare_draw_items(const void* a, const void* b) {
+    float da = ((const ChunkDrawItem*)a)->distance;
+    float db = ((const ChunkDrawItem*)b)->distance;
+    return (da > db) - (da < db);
+}
+
+void world_set_lod_distances(World* world, const float distances[CHUNK_LOD_COUNT - 1]) {
+    for (int i = 0; i < CHUNK_LOD_COUNT - 1; i++) {
+        if (distances[i] <= 0.0f || (i > 0 && distances[i] < distances[i - 1])) {
+            fprintf(stderr, "WORLD: lod distances must be positive and increasing\n");
+            return;
+        }
+    }
+    memcpy(world->lod_distance, distances, sizeof(world->lod_distance));
+}
+
+// picks the level of detail for a squared camera distance and builds its mesh if stale
+static int world_select_lod(World* world, int i, float distance) {
+    int lod = 0;
+    while (lod < CHUNK_LOD_COUNT - 1 && distance >= world->lod_distance[lod] * world->lod_distance[lod]) {
+        lod++;
+    }
+
+    Chunk* chunk = &world->chunks[i];
+    if (lod > 0 && !(chunk->lod_valid & (1 << lod))) {
+        chunk_update_lod_mesh(chunk, lod);
+    }
+    return lod;
+}
+
+static void world_draw_chunk(const RenderContext* ctx, World* world, Shader* shader, const ChunkDrawItem* item, MeshPass pass) {
+    int i = item->chunk_index;
+    int x = i / (WORLD_SIZE_Y * WORLD_SIZE_Z);
+    int y = (i / WORLD_SIZE_Z) % WORLD_SIZE_Y;
+    int z = i % WORLD_SIZE_Z;
+
+    // set model matrix
+    mat4 model;
+    glm_mat4_identity(model);
+    vec3 translation = {
+        x * CHUNK_SIZE,
+        y * CHUNK_SIZE,
+        z * CHUNK_SIZE
+    };
+    glm_translate(model, translation);
+    shader_set_mat4(shader, "model", model);
+
+    vec3 box_min = { world->bounds.min_x[i], world->bounds.min_y[i], world->bounds.min_z[i] };
+    vec3 box_max = { world->bounds.max_x[i], world->bounds.max_y[i], world->bounds.max_z[i] };
+    bool conditional = occlusion_begin_conditional(&world->occlusion, i, box_min, box_max, ctx->camera_position);
+
+    // draw chunk
+    vec3 camera;
+    glm_vec3_sub((float*)ctx->camera_position, translation, camera);
+    chunk_draw(&world->chunks[i], shader, camera, pass, item->lod);
+
+    if (conditional) occlusion_end_conditional();
+}
+
+void world_draw(const RenderContext* ctx, World* world, Shader* shader) {
+	shader_use(shader);
+	shader_set_mat4(shader, "projection", ctx->projection);
+	shader_set_mat4(shader, "view", ctx->view);
+
+    // rebuild dirty meshes first, culling skips chunks without geometry
+    world_update_mesh(world);
+    occlusion_begin_frame(&world->occlusion);
+
+    for(int v = 0; v < world->visible_count; v++) {
+        world->chunks[world->visible_chunks[v]].visible = false;
+    }
+    world->visible_count = chunk_tree_cull(&world->tree, &ctx->frustum, world->visible_chunks);
+    world_cull_occluded(world, ctx);
+
+    // sort by distance so near chunks fill the depth buffer first
+    for(int v = 0; v < world->visible_count; v++) {
+        int i = world->visible_chunks[v];
+        world->chunks[i].visible = true;
+
+        vec3 center = {
+            (world->bounds.min_x[i] + world->bounds.max_x[i]) * 0.5f,
+            (world->bounds.min_y[i] + world->bounds.max_y[i]) * 0.5f,
+            (world->bounds.min_z[i] + world->bounds.max_z[i]) * 0.5f
+        };
+        vec3 delta;
+        glm_vec3_sub(center, (float*)ctx->camera_position, delta);
+
+        world->draw_items[v].distance = glm_vec3_dot(delta, delta);
+        world->draw_items[v].chunk_index = i;
+    }
+    qsort(world->draw_items, world->visible_count, sizeof(ChunkDrawItem), compare_draw_items);
+
+    if (world->software_occlusion) world_cull_software(world, ctx);
+
+    for(int v = 0; v < world->visible_count; v++) {
+        ChunkDrawItem* item = &world->draw_items[v];
+        item->lod = world_select_lod(world, item->chunk_index, item->distance);
+    }
+
+    // opaque front to back
+    for(int v = 0; v < world->visible_count; v++) {
+        world_draw_chunk(ctx, world, shader, &world->draw_items[v], MESH_PASS_OPAQUE);
+    }
+
+    // test bounding boxes against the opaque depth, results are used next frame
+    if (world->occlusion.enabled) {
+        occlusion_issue_begin(&world->occlusion, ctx);
+        for(int v = 0; v < world->visible_count; v++) {
+            int i = world->draw_items[v].chunk_index;
+            vec3 box_min = { world->bounds.min_x[i], world->bounds.min_y[i], world->bounds.min_z[i] };
+            vec3 box_max = { world->bounds.max_x[i], world->bounds.max_y[i], world->bounds.max_z[i] };
+            occlusion_issue(&world->occlusion, i, box_min, box_max);
+        }
+        occlusion_issue_end(&world->occlusion);
+        shader_use(shader);
+    }
+
+    // translucent back to front, blended over the finished opaque depth buffer
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    for(int v = world->visible_count - 1; v >= 0; v--) {
+        // most chunks have nothing translucent, skip their uniform and query state
+        ChunkDrawItem* item = &world->draw_items[v];
+        if (!chunk_has_pass(&world->chunks[item->chunk_index], MESH_PASS_TRANSLUCENT, item->lod)) continue;
+        world_draw_chunk(ctx, world, shader, item, MESH_PASS_TRANSLUCENT);
+    }
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
@@ -2,15 +2,66 @@
 #define WORLD_H
 
 #include "chunk.h"
+#include "chunk_tree.h"
+#include "occlusion_query.h"
+#include "occlusion_buffer.h"
 #include "render_context.h"
+#include "terrain.h"
+#include "chunk_gen.h"
+#include "region.h"
+#include "chunk_io.h"
 
 #define WORLD_SIZE_X 3
 #define WORLD_SIZE_Y 3
 #define WORLD_SIZE_Z 3
 #define MAX_WORLD_SIZE (WORLD_SIZE_X * WORLD_SIZE_Y * WORLD_SIZE_Z)
+#define WORLD_DEFAULT_SEED 0x63637261667400ull // used until worlds can pick their own
+#define WORLD_SAVE_DIRECTORY "saves/world"
+#define WORLD_META_MAGIC 0x44575243u // "CRWD"
+#define WORLD_META_VERSION 1
+#define WORLD_AUTOSAVE_INTERVAL 30.0f         // seconds between the starts of autosave passes
+#define WORLD_AUTOSAVE_CHUNKS_PER_FRAME 4     // changed chunks snapshotted per frame during a pass
+#define WORLD_AUTOSAVE_MAX_PENDING 32         // the pass pauses while this many saves are queued
+#define OCCLUDER_CHUNK_COUNT 16 // nearest chunks rasterized into the occlusion buffer
+
+// default distances in blocks at which chunks switch to the next level of detail,
+// world_set_lod_distances overrides them at runtime
+#define LOD_DISTANCE_1 96.0f
+#define LOD_DISTANCE_2 192.0f
+#define LOD_DISTANCE_3 384.0f
+
+typedef struct {
+    float distance; // squared, camera to chunk center
+    int chunk_index;
+    int lod;
+} ChunkDrawItem;
 
 typedef struct World {
     Chunk* chunks;
+
+    ChunkBounds bounds;   // chunk AABBs for batch frustum culling
+    ChunkTree tree;       // hierarchy over bounds used to reject whole regions
+    int* visible_chunks;  // chunk indices written by world_draw
+    int visible_count;
+    ChunkDrawItem* draw_items; // visible chunks sorted near to far
+    OcclusionQueries occlusion; // optional, see occlusion_init
+    OcclusionBuffer* occlusion_buffer;
+    bool software_occlusion;
+    float lod_distance[CHUNK_LOD_COUNT - 1]; // camera distance where each coarser level starts
+
+    // connectivity culling scratch, one entry per chunk
+    int* cull_queue;
+    uint8_t* cull_entry_face; // face the search entered through, DIR_COUNT for the camera chunk
+    uint8_t* cull_traveled;   // directions taken to reach the chunk
+    bool* cull_reached;
+
+    uint64_t seed; // terrain is a pure function of the seed and chunk position
+    TerrainGenerator terrain;
+    ChunkGenerator generator; // builds chunks on worker threads
+    RegionStore regions;      // saved chunks, only the io thread touches it after world_init
+    ChunkIO io;               // disk reads and writes off the main thread
+    float autosave_timer;
+    int autosave_cursor;      // next chunk of the running autosave pass, MAX_WORLD_SIZE when idle
 } World;
 
 int world_get_chunk_index(int x, int y, int z);
@@ -19,12 +70,21 @@ Chunk* chunk_get_neighbor(World* world, int x, int y, int z, Direction dir);
 Chunk* world_get_chunk(World* world, int x, int y, int z);
 BlockType world_get_block(World* world, int x, int y, int z);
 void world_set_block(World* world, int x, int y, int z, BlockType block);
+void world_mark_block_dirty(World* world, int x, int y, int z); // remesh the sections showing this block
+void world_mark_box_dirty(World* world, int x0, int y0, int z0, int x1, int y1, int z1); // half-open box
+void world_fill_box(World* world, int x0, int y0, int z0, int x1, int y1, int z1, BlockType block); // half-open, world coordinates
 
-void world_init(World* world);
+void world_init(World* world, uint64_t seed, const char* save_directory); // a saved world keeps its own seed
 void world_unload(World* world);
-void world_generate(World* world);
+void world_load(World* world); // reads saved chunks and generates the rest, blocks until done
+void world_save(World* world); // queues every changed chunk, written by the io thread
+void world_autosave(World* world, float delta_time); // incremental, call once per frame
+void world_poll(World* world, const vec3 focus); // installs finished loads and generated chunks, once per frame
+int world_publish_generated(World* world); // installs finished chunks, call once per frame
+void world_get_spawn(World* world, vec3 out_position); // above the surface at the world center
 void world_update_mesh(World* world);
 void world_update_light(World* world);
 void world_draw(const RenderContext* ctx, World* world, Shader* shader);
+void world_set_lod_distances(World* world, const float distances[CHUNK_LOD_COUNT - 1]); // in blocks, increasing
 
 #endif // WORLD_H
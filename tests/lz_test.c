@@ -0,0 +1,122 @@
+#include "test.h"
+#include "lz.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// buffers are allocated at their exact size, so sanitizer builds catch any
+// read or write past them
+
+static uint32_t random_state = 12345;
+
+static uint32_t random_next(void) {
+    random_state = random_state * 1664525u + 1013904223u;
+    return random_state >> 8;
+}
+
+typedef enum {
+    INPUT_ZEROS,
+    INPUT_RANDOM,
+    INPUT_PATTERN,    // short repeats, overlapping matches
+    INPUT_FAR_REPEAT, // a block repeated near LZ_MAX_OFFSET back
+    INPUT_MIXED,      // long literal runs between long matches
+    INPUT_COUNT
+} InputKind;
+
+static void make_input(InputKind kind, uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        switch (kind) {
+            case INPUT_ZEROS: data[i] = 0; break;
+            case INPUT_RANDOM: data[i] = (uint8_t)random_next(); break;
+            case INPUT_PATTERN: data[i] = (uint8_t)"abcab"[i % 5]; break;
+            case INPUT_FAR_REPEAT: data[i] = i < 60000 ? (uint8_t)random_next() : data[i - 60000]; break;
+            case INPUT_MIXED: data[i] = (i / 300) % 2 ? (uint8_t)random_next() : (uint8_t)(i / 600); break;
+            default: break;
+        }
+    }
+}
+
+// compresses, checks the round trip, and returns the compressed stream
+static uint8_t* round_trip(const uint8_t* data, size_t size, size_t* packed_size) {
+    size_t capacity = LZ_BOUND(size);
+    uint8_t* packed = malloc(capacity);
+    uint8_t* out = malloc(size ? size : 1);
+    *packed_size = lz_compress(data, size, packed, capacity);
+    CHECK(*packed_size > 0 && *packed_size <= capacity);
+
+    CHECK(lz_decompress(packed, *packed_size, out, size));
+    CHECK(memcmp(out, data, size) == 0);
+    free(out);
+    return packed;
+}
+
+// a damaged stream may decode to garbage, but never past the output or input
+static void decode_damaged(const uint8_t* packed, size_t packed_size, const uint8_t* data, size_t size, bool truncated) {
+    uint8_t* copy = malloc(packed_size ? packed_size : 1);
+    uint8_t* out = malloc(size ? size : 1);
+    memcpy(copy, packed, packed_size);
+
+    bool ok = lz_decompress(copy, packed_size, out, size);
+    // cutting off a trailing empty token leaves a valid stream
+    if (truncated && ok) CHECK(memcmp(out, data, size) == 0);
+
+    free(out);
+    free(copy);
+}
+
+static void test_input(InputKind kind, size_t size) {
+    uint8_t* data = malloc(size ? size : 1);
+    make_input(kind, data, size);
+
+    size_t packed_size;
+    uint8_t* packed = round_trip(data, size, &packed_size);
+    if (size >= 1000 && (kind == INPUT_ZEROS || kind == INPUT_PATTERN)) CHECK(packed_size < size / 10);
+
+    // the size has to match exactly
+    uint8_t* out = malloc(size + 1);
+    CHECK(!lz_decompress(packed, packed_size, out, size + 1));
+    if (size > 0) CHECK(!lz_decompress(packed, packed_size, out, size - 1));
+    free(out);
+
+    // every truncation, and every prefix of the stream
+    for (size_t cut = 0; cut < packed_size; cut++) {
+        decode_damaged(packed, cut, data, size, true);
+    }
+
+    // single flipped bytes, and runs of random ones
+    for (int trial = 0; trial < 200 && packed_size > 0; trial++) {
+        uint8_t* corrupt = malloc(packed_size);
+        memcpy(corrupt, packed, packed_size);
+        int damage = 1 + (trial % 4) * 4;
+        for (int d = 0; d < damage; d++) {
+            corrupt[random_next() % packed_size] ^= (uint8_t)(1 + random_next() % 255);
+        }
+        decode_damaged(corrupt, packed_size, data, size, false);
+        free(corrupt);
+    }
+
+    free(packed);
+    free(data);
+}
+
+int main(void) {
+    for (InputKind kind = 0; kind < INPUT_COUNT; kind++) {
+        size_t size = kind == INPUT_FAR_REPEAT ? 70000 : 5000;
+        test_input(kind, size);
+        test_input(kind, 17); // shorter than any useful match
+    }
+    test_input(INPUT_ZEROS, 0);
+
+    // hand built streams that point outside what was decoded
+    uint8_t out[64];
+    const uint8_t zero_offset[] = { 0x10, 'a', 0x00, 0x00 };
+    CHECK(!lz_decompress(zero_offset, sizeof(zero_offset), out, 5));
+    const uint8_t offset_before_start[] = { 0x10, 'a', 0x02, 0x00 };
+    CHECK(!lz_decompress(offset_before_start, sizeof(offset_before_start), out, 5));
+    const uint8_t literals_past_input[] = { 0xf0, 0xff, 0xff, 0x10, 'a' };
+    CHECK(!lz_decompress(literals_past_input, sizeof(literals_past_input), out, sizeof(out)));
+    const uint8_t match_past_output[] = { 0x1f, 'a', 0x01, 0x00, 0xff, 0x00 };
+    CHECK(!lz_decompress(match_past_output, sizeof(match_past_output), out, sizeof(out)));
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,93 @@
+#include "test.h"
+#include "noise.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the batch paths have to match the scalar ones bit for bit, whichever
+// NOISE_BATCH_WIDTH this build picked. the default build has no -mavx2, so
+// the avx2 path only runs here when configured with CCRAFT_NOISE_AVX2=ON
+
+#define TEST_COUNT 1003 // not a multiple of any batch width, the tail runs scalar
+#define TEST_OCTAVES 5
+
+static uint32_t random_state = 12345;
+
+static uint32_t random_next(void) {
+    random_state = random_state * 1664525u + 1013904223u;
+    return random_state >> 8;
+}
+
+// negative and positive, whole and fractional, up to far from the origin
+static float random_coord(float range) {
+    return ((float)random_next() / (float)(1u << 24) * 2.0f - 1.0f) * range;
+}
+
+static void test_batch(const NoiseContext* ctx, float range, int count) {
+    float* x = malloc(count * sizeof(float));
+    float* y = malloc(count * sizeof(float));
+    float* z = malloc(count * sizeof(float));
+    float* batch = malloc(count * sizeof(float));
+    float* scalar = malloc(count * sizeof(float));
+    for (int i = 0; i < count; i++) {
+        x[i] = random_coord(range);
+        y[i] = random_coord(range);
+        z[i] = random_coord(range);
+    }
+
+    noise_perlin_3d_batch(ctx, x, y, z, batch, count);
+    for (int i = 0; i < count; i++) {
+        scalar[i] = noise_perlin_3d(ctx, x[i], y[i], z[i]);
+    }
+    CHECK(memcmp(batch, scalar, count * sizeof(float)) == 0);
+
+    noise_fbm_batch(ctx, x, y, z, batch, count, TEST_OCTAVES);
+    for (int i = 0; i < count; i++) {
+        scalar[i] = noise_fbm(ctx, x[i], y[i], z[i], TEST_OCTAVES);
+    }
+    CHECK(memcmp(batch, scalar, count * sizeof(float)) == 0);
+
+    free(scalar);
+    free(batch);
+    free(z);
+    free(y);
+    free(x);
+}
+
+static void test_grid(const NoiseContext* ctx, int origin_x, int origin_z) {
+    enum { SIZE_X = 5, SIZE_Z = 19 };
+    const float scale = 0.01f;
+    const float y = 0.5f;
+    float grid[SIZE_X * SIZE_Z];
+    float scalar[SIZE_X * SIZE_Z];
+
+    noise_fbm_grid_2d(ctx, origin_x, origin_z, SIZE_X, SIZE_Z, scale, y, TEST_OCTAVES, grid);
+    for (int i = 0; i < SIZE_X; i++) {
+        for (int k = 0; k < SIZE_Z; k++) {
+            scalar[i * SIZE_Z + k] = noise_fbm(ctx, (origin_x + i) * scale, y, (origin_z + k) * scale, TEST_OCTAVES);
+        }
+    }
+    CHECK(memcmp(grid, scalar, sizeof(grid)) == 0);
+}
+
+int main(void) {
+    printf("batch width: %d\n", NOISE_BATCH_WIDTH);
+
+    NoiseContext ctx;
+    noise_context_init(&ctx, 1234);
+
+    test_batch(&ctx, 4.0f, TEST_COUNT);
+    test_batch(&ctx, 300.0f, TEST_COUNT);
+    test_batch(&ctx, 100000.0f, TEST_COUNT);
+    // every count up to a few batches, so each tail length is covered
+    for (int count = 1; count <= NOISE_BATCH_WIDTH * 3 + 1; count++) {
+        test_batch(&ctx, 50.0f, count);
+    }
+
+    test_grid(&ctx, 0, 0);
+    test_grid(&ctx, -37, -1000);
+    test_grid(&ctx, 4096, -17);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,49 @@
+#include "test.h"
+#include "occlusion_buffer.h"
+
+// the software occlusion buffer is plain C, no context needed
+
+static void add_wall(OcclusionBuffer* buffer, float x0, float x1, float y0, float y1, float z) {
+    vec3 corners[4] = {
+        { x0, y0, z },
+        { x1, y0, z },
+        { x1, y1, z },
+        { x0, y1, z }
+    };
+    occlusion_buffer_add_quad(buffer, corners);
+}
+
+int main(void) {
+    static OcclusionBuffer buffer;
+    mat4 projection, view;
+    vec3 eye = { 0.0f, 0.0f, 0.0f };
+    vec3 center = { 0.0f, 0.0f, -1.0f };
+    vec3 up = { 0.0f, 1.0f, 0.0f };
+    glm_perspective(glm_rad(70.0f), (float)OCCLUSION_BUFFER_WIDTH / OCCLUSION_BUFFER_HEIGHT, 0.1f, 500.0f, projection);
+    glm_lookat(eye, center, up, view);
+
+    // camera looks down -z, a wall across the whole view sits at z = -10
+    vec3 behind_min = { -2.0f, -2.0f, -20.0f }, behind_max = { 2.0f, 2.0f, -16.0f };
+    vec3 straddling_min = { -2.0f, -2.0f, -12.0f }, straddling_max = { 2.0f, 2.0f, -6.0f };
+    vec3 in_front_min = { -2.0f, -2.0f, -8.0f }, in_front_max = { 2.0f, 2.0f, -5.0f };
+
+    occlusion_buffer_clear(&buffer, projection, view);
+    CHECK(occlusion_buffer_test_aabb(&buffer, behind_min, behind_max));
+
+    add_wall(&buffer, -1000.0f, 1000.0f, -1000.0f, 1000.0f, -10.0f);
+    CHECK(!occlusion_buffer_test_aabb(&buffer, behind_min, behind_max));
+    CHECK(occlusion_buffer_test_aabb(&buffer, straddling_min, straddling_max));
+    CHECK(occlusion_buffer_test_aabb(&buffer, in_front_min, in_front_max));
+
+    // a wall over the left half leaves the right half of the box visible
+    occlusion_buffer_clear(&buffer, projection, view);
+    add_wall(&buffer, -1000.0f, 0.0f, -1000.0f, 1000.0f, -10.0f);
+    CHECK(occlusion_buffer_test_aabb(&buffer, behind_min, behind_max));
+
+    // boxes reaching behind the camera are always kept
+    add_wall(&buffer, -1000.0f, 1000.0f, -1000.0f, 1000.0f, -10.0f);
+    vec3 around_min = { -1.0f, -1.0f, -1.0f }, around_max = { 1.0f, 1.0f, 1.0f };
+    CHECK(occlusion_buffer_test_aabb(&buffer, around_min, around_max));
+
+    return TEST_RESULT;
+}
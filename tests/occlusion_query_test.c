@@ -0,0 +1,101 @@
+#include "test.h"
+#include "occlusion_query.h"
+
+#include <GLFW/glfw3.h>
+
+// needs a GL 3.3 context, a software one is enough:
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ctest -R occlusion_query
+// skipped when no window can be created
+
+#define TEST_SIZE 64
+
+static const vec3 chunk_min = { -0.5f, -0.5f, -0.5f };
+static const vec3 chunk_max = { 15.5f, 15.5f, 15.5f };
+
+// writes depth only, like the opaque pass does for the chunk geometry
+static void draw_depth_box(OcclusionQueries* oq, const vec3 box_min, const vec3 box_max) {
+    mat4 model;
+    vec3 size;
+    glm_mat4_identity(model);
+    glm_translate(model, (float*)box_min);
+    glm_vec3_sub((float*)box_max, (float*)box_min, size);
+    glm_scale(model, size);
+
+    shader_use(&oq->shader);
+    shader_set_mat4(&oq->shader, "model", model);
+    glBindVertexArray(oq->vao);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0);
+    glBindVertexArray(0);
+}
+
+static GLuint query_box(OcclusionQueries* oq, const RenderContext* ctx, int index) {
+    occlusion_issue_begin(oq, ctx);
+    occlusion_issue(oq, index, chunk_min, chunk_max);
+    occlusion_issue_end(oq);
+
+    GLuint samples = 0;
+    glGetQueryObjectuiv(oq->queries[index], GL_QUERY_RESULT, &samples);
+    return samples;
+}
+
+int main(void) {
+    if (!glfwInit()) return TEST_SKIP;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(TEST_SIZE, TEST_SIZE, "occlusion_query_test", NULL, NULL);
+    if (!window) {
+        glfwTerminate();
+        return TEST_SKIP;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return TEST_SKIP;
+    }
+    printf("renderer: %s\n", (const char*)glGetString(GL_RENDERER));
+
+    OcclusionQueries oq;
+    occlusion_init(&oq, 3, CCRAFT_SOURCE_DIR "/res/shaders/bounds.vert", CCRAFT_SOURCE_DIR "/res/shaders/bounds.frag");
+    CHECK(oq.shader.ID != 0);
+    while (glGetError() != GL_NO_ERROR) {} // only errors from the queries below count
+
+    RenderContext ctx;
+    vec3 eye = { 7.5f, 7.5f, -40.0f };
+    vec3 center = { 7.5f, 7.5f, 7.5f };
+    vec3 up = { 0.0f, 1.0f, 0.0f };
+    glm_perspective(glm_rad(60.0f), 1.0f, 0.1f, 500.0f, ctx.projection);
+    glm_lookat(eye, center, up, ctx.view);
+    glm_vec3_copy(eye, ctx.camera_position);
+
+    glViewport(0, 0, TEST_SIZE, TEST_SIZE);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    shader_use(&oq.shader);
+    shader_set_mat4(&oq.shader, "projection", ctx.projection);
+    shader_set_mat4(&oq.shader, "view", ctx.view);
+
+    // the chunk's own faces lie on its bounds, they must not hide its box
+    glClear(GL_DEPTH_BUFFER_BIT);
+    draw_depth_box(&oq, chunk_min, chunk_max);
+    CHECK(query_box(&oq, &ctx, 0) > 0);
+
+    // a wall covering the whole view in front of the chunk hides it
+    glClear(GL_DEPTH_BUFFER_BIT);
+    draw_depth_box(&oq, (vec3){ -200.0f, -200.0f, -20.0f }, (vec3){ 200.0f, 200.0f, -19.0f });
+    CHECK(query_box(&oq, &ctx, 1) == 0);
+
+    // a wall covering half of it does not
+    glClear(GL_DEPTH_BUFFER_BIT);
+    draw_depth_box(&oq, (vec3){ -200.0f, -200.0f, -20.0f }, (vec3){ 7.5f, 200.0f, -19.0f });
+    CHECK(query_box(&oq, &ctx, 2) > 0);
+
+    CHECK(glGetError() == GL_NO_ERROR);
+
+    occlusion_free(&oq);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return TEST_RESULT;
+}
@@ -0,0 +1,19 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+// each test is its own executable, main returns TEST_RESULT
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define TEST_SKIP 77 // ctest reports the test as skipped, see SKIP_RETURN_CODE
+#define TEST_RESULT (test_failures ? 1 : 0)
+
+#endif // TEST_H
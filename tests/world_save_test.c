@@ -0,0 +1,87 @@
+#include "test.h"
+#include "world.h"
+
+#include <stdlib.h>
+
+// edits have to reach the disk whatever light propagation did to the chunk
+// flags in between, through world_save on exit and through autosave
+
+#define TEST_SEED 1234
+#define TEST_DIRECTORY "world_save_test"
+
+static void remove_save(void) {
+    remove(TEST_DIRECTORY "/world.dat");
+    remove(TEST_DIRECTORY "/r.0.0.bin");
+}
+
+// one frame of the game loop that touches chunk state
+static void run_frame(World* world) {
+    world_update_light(world);
+}
+
+static BlockType other_block(BlockType type) {
+    return type == BLOCK_GLASS ? BLOCK_STONE : BLOCK_GLASS;
+}
+
+static uint8_t light_at(World* world, int x, int y, int z) {
+    Chunk* chunk = world_get_chunk(world, x / CHUNK_SIZE, y / CHUNK_SIZE, z / CHUNK_SIZE);
+    return chunk->blocks[chunk_get_block_index(x % CHUNK_SIZE, y % CHUNK_SIZE, z % CHUNK_SIZE)].light_level;
+}
+
+int main(void) {
+    World* world = calloc(1, sizeof(World));
+    if (!world) return 1;
+    remove_save();
+
+    // saved on exit
+    world_init(world, TEST_SEED, TEST_DIRECTORY);
+    run_frame(world);
+    BlockType first = other_block(world_get_block(world, 5, 20, 7));
+    world_set_block(world, 5, 20, 7, first);
+    run_frame(world);
+    world_save(world);
+    world_unload(world);
+
+    world_init(world, TEST_SEED, TEST_DIRECTORY);
+    CHECK(world_get_block(world, 5, 20, 7) == first);
+
+    // saved by autosave, spread over frames
+    run_frame(world);
+    BlockType second = other_block(world_get_block(world, 40, 3, 30));
+    world_set_block(world, 40, 3, 30, second);
+    run_frame(world);
+    world_autosave(world, WORLD_AUTOSAVE_INTERVAL);
+    for (int frame = 0; frame < MAX_WORLD_SIZE && world->autosave_cursor < MAX_WORLD_SIZE; frame++) {
+        run_frame(world);
+        world_autosave(world, 0.0f);
+    }
+    chunk_io_wait(&world->io);
+    chunk_io_poll(&world->io);
+
+    Chunk* chunk = world_get_chunk(world, 40 / CHUNK_SIZE, 3 / CHUNK_SIZE, 30 / CHUNK_SIZE);
+    CHECK(chunk->saved_generation == chunk->generation);
+    world_unload(world);
+
+    world_init(world, TEST_SEED, TEST_DIRECTORY);
+    CHECK(world_get_block(world, 5, 20, 7) == first);
+    CHECK(world_get_block(world, 40, 3, 30) == second);
+
+    // a lamp on a chunk border lights the untouched neighbor once the chunk
+    // holding it is read back, while the neighbor is generated again
+    CHECK(world_get_block(world, CHUNK_SIZE, 40, 7) == BLOCK_AIR);
+    run_frame(world);
+    world_set_block(world, CHUNK_SIZE - 1, 40, 7, BLOCK_LIGHT);
+    run_frame(world);
+    world_save(world);
+    world_unload(world);
+
+    world_init(world, TEST_SEED, TEST_DIRECTORY);
+    run_frame(world);
+    CHECK(world_get_block(world, CHUNK_SIZE - 1, 40, 7) == BLOCK_LIGHT);
+    CHECK(light_at(world, CHUNK_SIZE, 40, 7) == block_get_emission(BLOCK_LIGHT) - 1);
+    world_unload(world);
+
+    free(world);
+    remove_save();
+    return TEST_RESULT;
+}